@@ -0,0 +1,72 @@
+#ifndef ASYNC_RECORD_FETCHER_H
+#define ASYNC_RECORD_FETCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @class AsyncRecordFetcher
+ * @brief Reads a batch of length-indicated records at known offsets with many
+ *        reads in flight at once.
+ *
+ * On Linux the reads go through io_uring (raw syscalls, no liburing needed).
+ * Elsewhere, or when io_uring can't be set up (old kernel, seccomp), a pool of
+ * worker threads issues plain positional reads instead.
+ *
+ * Each record is fetched with one read of FIRST_READ_SIZE bytes covering the
+ * length prefix and, for normal-sized records, the whole body; longer records
+ * get one follow-up read for the rest.
+ *
+ * A length prefix that would run past the end of the file is reported as an
+ * error before anything is allocated for it, so a stale index or a corrupt
+ * file can't trigger a multi-gigabyte read.
+ */
+class AsyncRecordFetcher {
+public:
+    static const size_t FIRST_READ_SIZE = 256;
+
+    /// Called as onRecord(batchIndex, record) on the thread that called fetchBatch(),
+    /// in completion order. The record excludes its length prefix.
+    using Callback = std::function<void(size_t batchIndex, const std::string& record)>;
+
+    /**
+     * @param dataFileName Binary data file the offsets point into.
+     * @param queueDepth Maximum number of reads in flight.
+     */
+    explicit AsyncRecordFetcher(const std::string& dataFileName, unsigned queueDepth = 32);
+    ~AsyncRecordFetcher();
+
+    AsyncRecordFetcher(const AsyncRecordFetcher&) = delete;
+    AsyncRecordFetcher& operator=(const AsyncRecordFetcher&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+
+    /// True if batches are served by io_uring rather than the thread pool.
+    bool usingIoUring() const { return ring != nullptr; }
+
+    /**
+     * @brief Fetches every record in @p offsets (e.g. from IndexManager::findOffset()).
+     * @return False if any record could not be read; the others are still delivered.
+     */
+    bool fetchBatch(const std::vector<uint64_t>& offsets, const Callback& onRecord);
+
+private:
+    struct Ring;                 ///< io_uring state, only defined on Linux
+
+    std::string fileName;
+    unsigned queueDepth;
+    int fd = -1;
+    uint64_t fileSize = 0;       ///< Refreshed at the start of every batch
+    Ring* ring = nullptr;
+
+    bool fetchWithRing(const std::vector<uint64_t>& offsets, const Callback& onRecord);
+    bool fetchWithThreads(const std::vector<uint64_t>& offsets, const Callback& onRecord);
+    bool readRecordAt(uint64_t offset, std::string& record) const;
+    bool refreshFileSize();
+    bool recordFits(uint64_t offset, uint32_t recordLength) const;
+};
+
+#endif // ASYNC_RECORD_FETCHER_H
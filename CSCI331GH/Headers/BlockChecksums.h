@@ -0,0 +1,68 @@
+#ifndef BLOCK_CHECKSUMS_H
+#define BLOCK_CHECKSUMS_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+const uint32_t DEFAULT_CHECKSUM_BLOCK = 64 * 1024;  ///< 64 KB
+
+/**
+ * @class BlockChecksums
+ * @brief CRC-32C of every fixed-size block of a data file, kept in a sidecar
+ *        file ("<data file>.crc") so the record layout itself is unchanged.
+ *
+ * The sidecar describes the file as of its last write() and is replaced
+ * atomically (temp file + rename). Editors must discard() it before changing
+ * the data file and write() a new one when done, so a missing sidecar means
+ * "unknown", never "corrupt".
+ *
+ * Sidecar format:
+ *   [magic:char[8]][blockSize:uint32_t][dataLength:uint64_t][blockCount:uint64_t]
+ *   [crc:uint32_t] x blockCount
+ *   [crc of everything above:uint32_t]
+ */
+class BlockChecksums {
+public:
+    static std::string sidecarName(const std::string& dataFileName) { return dataFileName + ".crc"; }
+
+    /**
+     * @brief Checksums a data file (blocks in parallel) and writes its sidecar.
+     */
+    static bool write(const std::string& dataFileName, uint32_t blockSize = DEFAULT_CHECKSUM_BLOCK);
+
+    /**
+     * @brief Removes a data file's sidecar because the file is about to change.
+     * @return False if a sidecar exists and couldn't be removed.
+     */
+    static bool discard(const std::string& dataFileName);
+
+    /**
+     * @brief Loads and self-checks the sidecar of a data file.
+     */
+    bool load(const std::string& dataFileName);
+
+    bool isLoaded() const { return blockSize != 0; }
+
+    /**
+     * @brief Re-checksums the whole file in parallel and compares every block.
+     * Bad blocks and size mismatches are reported on cerr.
+     */
+    bool verifyFile(const std::string& dataFileName) const;
+
+    /**
+     * @brief Checks just the blocks overlapping [offset, offset + length), e.g. one record.
+     */
+    bool verifyRange(std::istream& data, uint64_t offset, uint64_t length) const;
+
+private:
+    uint32_t blockSize = 0;
+    uint64_t dataLength = 0;
+    std::vector<uint32_t> blockCrcs;
+
+    static bool checksumFile(const std::string& dataFileName, uint32_t blockSize,
+                             uint64_t& length, std::vector<uint32_t>& crcs);
+};
+
+#endif // BLOCK_CHECKSUMS_H
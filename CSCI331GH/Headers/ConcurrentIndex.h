@@ -0,0 +1,124 @@
+#ifndef CONCURRENT_INDEX_H
+#define CONCURRENT_INDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "IndexManager.h"
+
+/**
+ * @class ConcurrentIndex
+ * @brief Publishes immutable IndexManager snapshots to any number of reader threads.
+ *
+ * Readers never wait on a lock: they pin the current epoch in a reader record, load
+ * the snapshot pointer, query it, and release the record. Records live in a list
+ * that grows when every existing one is busy, so readers never wait on each other.
+ * A writer builds a complete new IndexManager off to the side and installs it with
+ * a single atomic pointer swap. The old snapshot is retired and deleted once every
+ * reader that could still be looking at it has left (epoch-based reclamation):
+ * by the next publish(), or by the last such reader as it releases its guard.
+ */
+class ConcurrentIndex {
+private:
+    /// One reader's pinned epoch; records are reused but only freed with the index.
+    struct ReaderRecord {
+        std::atomic<uint64_t> epoch{0};  ///< 0 = idle
+        ReaderRecord* next = nullptr;
+    };
+
+public:
+    /**
+     * @class ReadGuard
+     * @brief Keeps one snapshot alive while the holder reads from it.
+     */
+    class ReadGuard {
+    public:
+        ReadGuard(ReadGuard&& other) noexcept
+            : owner(other.owner), record(other.record), snapshot(other.snapshot) {
+            other.record = nullptr;
+            other.snapshot = nullptr;
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ~ReadGuard() {
+            if (record) owner->release(record);
+        }
+
+        /// @return The pinned snapshot, or nullptr if nothing has been published yet.
+        const IndexManager* get() const { return snapshot; }
+        const IndexManager* operator->() const { return snapshot; }
+        explicit operator bool() const { return snapshot != nullptr; }
+
+    private:
+        friend class ConcurrentIndex;
+        ReadGuard(const ConcurrentIndex* o, ReaderRecord* r, const IndexManager* snap)
+            : owner(o), record(r), snapshot(snap) {}
+
+        const ConcurrentIndex* owner;
+        ReaderRecord* record;
+        const IndexManager* snapshot;
+    };
+
+    ConcurrentIndex();
+    ~ConcurrentIndex();
+
+    ConcurrentIndex(const ConcurrentIndex&) = delete;
+    ConcurrentIndex& operator=(const ConcurrentIndex&) = delete;
+
+    /**
+     * @brief Pins the current snapshot for the lifetime of the returned guard.
+     */
+    ReadGuard acquire() const;
+
+    /**
+     * @brief Lock-free lookup against the current snapshot.
+     * @return The byte offset in the data file, or UINT64_MAX if not found.
+     */
+    uint64_t findOffset(const std::string& zip) const;
+
+    /**
+     * @brief Number of entries in the current snapshot.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Atomically replaces the current snapshot with @p next.
+     *
+     * The previous snapshot is retired and freed once no reader can reach it.
+     */
+    void publish(std::unique_ptr<IndexManager> next);
+
+    /**
+     * @brief Loads a fresh snapshot from an index file and publishes it.
+     * @return False (and keeps the current snapshot) if the file can't be read.
+     */
+    bool reloadFromIndexFile(const std::string& indexFileName);
+
+    /**
+     * @brief Rescans a binary data file into a fresh snapshot and publishes it.
+     * @return False (and keeps the current snapshot) if the file can't be read.
+     */
+    bool rebuildFromDataFile(const std::string& dataFileName);
+
+private:
+    const uint64_t instanceId;  ///< Unique per object, so thread-local hints never go stale
+    std::atomic<const IndexManager*> current;
+    std::atomic<uint64_t> globalEpoch;
+    mutable std::atomic<ReaderRecord*> readers;  ///< Grow-only list of reader records
+
+    /// Serializes writers; readers only ever try_lock it to reclaim on the way out
+    mutable std::mutex writerMutex;
+    mutable std::vector<std::pair<uint64_t, const IndexManager*>> retired;  ///< (retire epoch, snapshot)
+    mutable std::atomic<size_t> retiredCount{0};
+
+    void release(ReaderRecord* record) const;
+    void reclaim() const;
+};
+
+#endif // CONCURRENT_INDEX_H
@@ -0,0 +1,25 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief CRC-32C (Castagnoli) of a buffer.
+ *
+ * Uses the SSE4.2 crc32 instruction (or the ARMv8 CRC extension) when the CPU
+ * has it, and a slicing-by-8 table lookup otherwise. The result is the same
+ * either way.
+ *
+ * @param data Bytes to checksum.
+ * @param length Number of bytes.
+ * @param crc Result of a previous call, to continue a checksum over several buffers.
+ */
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief True if crc32c() is running on the hardware instruction path.
+ */
+bool crc32cIsHardwareAccelerated();
+
+#endif // CRC32C_H
@@ -0,0 +1,56 @@
+#ifndef DATA_FILE_WRITER_H
+#define DATA_FILE_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "HeaderBuffer.h"
+#include "IndexManager.h"
+
+/**
+ * @class DataFileWriter
+ * @brief Streams records into a new length-indicated data file and builds its
+ *        index in the same pass.
+ *
+ * The header is written up front with a record count of 0 and patched in place
+ * by close(), so the input only has to be read once. Records go to a temp file
+ * that close() renames over the data file, so an existing file is replaced
+ * whole or not at all.
+ */
+class DataFileWriter {
+public:
+    /**
+     * @brief Creates the data file and writes its header.
+     * @param dataFileName Path of the binary data file to create.
+     * @param indexFileName Index path recorded in the header and written by close().
+     * @param bufferBytes Size of the output stream buffer (0 = library default).
+     */
+    bool open(const std::string& dataFileName, const std::string& indexFileName,
+              size_t bufferBytes = 0);
+
+    /**
+     * @brief Appends one CSV record as [length:uint32_t][record].
+     */
+    bool append(const std::string& record);
+
+    /**
+     * @brief Patches the record count into the header, swaps the file into place
+     *        and writes the index file and checksum sidecar.
+     */
+    bool close();
+
+    uint64_t recordCount() const { return header.recordCount; }
+    const IndexManager& index() const { return indexManager; }
+
+private:
+    std::vector<char> streamBuffer;  ///< Declared before out so it outlives the stream
+    std::ofstream out;
+    std::string fileName;
+    std::string tempName;  ///< Where records are written until close() renames it
+    HeaderRecordBuffer header;
+    IndexManager indexManager;
+};
+
+#endif // DATA_FILE_WRITER_H
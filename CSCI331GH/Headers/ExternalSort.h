@@ -0,0 +1,34 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <cstddef>
+#include <string>
+
+const size_t DEFAULT_SORT_MEMORY = 64u * 1024u * 1024u;  ///< 64 MB
+const size_t MIN_SORT_MEMORY = 1024u * 1024u;             ///< Smaller budgets are raised to 1 MB
+
+/**
+ * @brief Builds a data file whose records are in ZIP (primary key) order from an
+ *        unsorted CSV, using at most roughly @p memoryBudget bytes of RAM.
+ *
+ * Phase 1 reads the CSV sequentially into memory-sized chunks; the chunks are
+ * sorted and written as run files in parallel. Phase 2 merges the runs with a
+ * k-way loser tree (in several passes if there are more runs than fit in the
+ * budget), streaming the final pass straight into a DataFileWriter so the index
+ * is built in the same pass. Run files are removed afterwards.
+ *
+ * The budget covers buffered records, stream buffers and sort scratch space in
+ * both phases; the number of parallel run writers shrinks to fit it. The index
+ * being built for the output file is not counted.
+ *
+ * @param inputCSVFileName Source CSV (first line is a header row).
+ * @param dataFileName Sorted binary data file to create.
+ * @param indexFileName Index file to create.
+ * @param memoryBudget Approximate bytes available for records and I/O buffers
+ *                     (at least MIN_SORT_MEMORY).
+ * @return False if any file could not be read or written.
+ */
+bool externalSortToDataFile(const std::string& inputCSVFileName, const std::string& dataFileName,
+                            const std::string& indexFileName, size_t memoryBudget = DEFAULT_SORT_MEMORY);
+
+#endif // EXTERNAL_SORT_H
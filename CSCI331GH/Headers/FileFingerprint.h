@@ -0,0 +1,32 @@
+#ifndef FILE_FINGERPRINT_H
+#define FILE_FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+static const uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+
+/**
+ * @brief 64-bit FNV-1a, continuing from @p hash.
+ */
+inline uint64_t fnv1a(const char* data, size_t length, uint64_t hash = FNV1A_OFFSET_BASIS) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a(const std::string& s, uint64_t hash = FNV1A_OFFSET_BASIS) {
+    return fnv1a(s.data(), s.size(), hash);
+}
+
+/**
+ * @brief Size of a file and an FNV-1a hash of its first block plus evenly spaced
+ *        sample blocks (small files are hashed whole), so it reads a few KB at most.
+ * @return False if the file can't be read.
+ */
+bool sampledFileHash(const std::string& fileName, uint64_t& size, uint64_t& sampleHash);
+
+#endif // FILE_FINGERPRINT_H
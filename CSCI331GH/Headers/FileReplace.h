@@ -0,0 +1,14 @@
+#ifndef FILE_REPLACE_H
+#define FILE_REPLACE_H
+
+#include <string>
+
+/**
+ * @brief Atomically renames @p tempName over @p fileName, replacing it if it exists.
+ *
+ * Readers (and a crash) see either the old file or the new one, never neither:
+ * on failure both files are left as they were and an error is reported.
+ */
+bool replaceFile(const std::string& tempName, const std::string& fileName);
+
+#endif // FILE_REPLACE_H
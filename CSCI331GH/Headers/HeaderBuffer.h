@@ -8,6 +8,7 @@
 #include <sstream>      // Required for the write-to-buffer technique
 #include <chrono>       // For getting the current date/time
 #include <iomanip>      // For formatting the date/time
+#include <limits>
 
 
 // Enum to represent the data type of a field
@@ -49,6 +50,9 @@ public:
     uint32_t version = 1;
     uint64_t recordCount = 0;
     uint16_t primaryKeyFieldIndex = 0;      // e.g., 0 for the first field (ZipCode)
+    // Version 3+: head of the deleted-record avail list and bytes held by tombstones
+    uint64_t availListHead = std::numeric_limits<uint64_t>::max();
+    uint64_t deadBytes = 0;
     std::string indexFileName;
     std::string creationDate;
     
@@ -69,6 +73,12 @@ public:
         #endif
         creationDate = date_ss.str();
 
+        rewriteHeader(out);
+    }
+
+    // Writes the header with its current values (creation date is kept), so an
+    // existing header can be overwritten in place without changing its size
+    void rewriteHeader(std::ostream& out) const {
         // Use a temporary in-memory buffer to easily calculate the total header size
         std::stringstream headerBuffer(std::ios::binary | std::ios::in | std::ios::out);
 
@@ -77,6 +87,10 @@ public:
         headerBuffer.write(reinterpret_cast<const char*>(&version), sizeof(version));
         headerBuffer.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
         headerBuffer.write(reinterpret_cast<const char*>(&primaryKeyFieldIndex), sizeof(primaryKeyFieldIndex));
+        if (version >= 3) {
+            headerBuffer.write(reinterpret_cast<const char*>(&availListHead), sizeof(availListHead));
+            headerBuffer.write(reinterpret_cast<const char*>(&deadBytes), sizeof(deadBytes));
+        }
 
         uint16_t indexNameLen = indexFileName.length();
         headerBuffer.write(reinterpret_cast<const char*>(&indexNameLen), sizeof(indexNameLen));
@@ -104,6 +118,10 @@ public:
         uint32_t totalHeaderSize = 0;
         if (!in.read(reinterpret_cast<char*>(&totalHeaderSize), sizeof(totalHeaderSize))) return false;
 
+        // A corrupt size would otherwise allocate an absurd buffer; real headers are tiny
+        const uint32_t maxHeaderSize = 1u << 20;
+        if (totalHeaderSize == 0 || totalHeaderSize > maxHeaderSize) return false;
+
         // For safety, you could read the header into a buffer to avoid reading past its end
         std::vector<char> buffer(totalHeaderSize);
         if (!in.read(buffer.data(), totalHeaderSize)) return false;
@@ -113,6 +131,10 @@ public:
         if (!headerBuffer.read(reinterpret_cast<char*>(&version), sizeof(version))) return false;
         if (!headerBuffer.read(reinterpret_cast<char*>(&recordCount), sizeof(recordCount))) return false;
         if (!headerBuffer.read(reinterpret_cast<char*>(&primaryKeyFieldIndex), sizeof(primaryKeyFieldIndex))) return false;
+        if (version >= 3) {
+            if (!headerBuffer.read(reinterpret_cast<char*>(&availListHead), sizeof(availListHead))) return false;
+            if (!headerBuffer.read(reinterpret_cast<char*>(&deadBytes), sizeof(deadBytes))) return false;
+        }
         
         uint16_t indexNameLen = 0;
         if (!headerBuffer.read(reinterpret_cast<char*>(&indexNameLen), sizeof(indexNameLen))) return false;
@@ -0,0 +1,94 @@
+#ifndef HOT_RECORD_CACHE_H
+#define HOT_RECORD_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ZipCodeRecordBuffer.h"
+
+/**
+ * @class HotRecordCache
+ * @brief Bounded cache of recently looked-up ZIP records, holding both the
+ *        decoded record and its already formatted output text.
+ *
+ * Entries are spread over independently locked shards so concurrent lookups
+ * rarely contend. Each shard evicts with the CLOCK algorithm: a hit just sets
+ * the entry's reference bit, and the clock hand gives referenced entries a
+ * second chance before replacing one.
+ */
+class HotRecordCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    /**
+     * @param capacity Maximum number of cached records across all shards; 0 disables
+     *                 the cache (every lookup misses, inserts are ignored).
+     * @param shardCount Number of independently locked shards.
+     */
+    explicit HotRecordCache(size_t capacity = 4096, size_t shardCount = 16);
+
+    /**
+     * @brief Copies the pre-rendered output for a ZIP code.
+     * @return False on a miss.
+     */
+    bool lookup(const std::string& zip, std::string& rendered);
+
+    /**
+     * @brief Copies the decoded record for a ZIP code.
+     * @return False on a miss.
+     */
+    bool lookupRecord(const std::string& zip, ZipCodeRecordBuffer& record);
+
+    /**
+     * @brief Caches a record (rendering it once), evicting if the shard is full.
+     */
+    void insert(const std::string& zip, const ZipCodeRecordBuffer& record);
+
+    /**
+     * @brief Drops a ZIP code, e.g. after its record was updated or deleted.
+     */
+    void invalidate(const std::string& zip);
+
+    void clear();
+    Stats stats() const;
+
+    /**
+     * @brief The six "Field: value" lines printed for a record.
+     */
+    static std::string render(const ZipCodeRecordBuffer& record);
+
+private:
+    struct Entry {
+        std::string zip;
+        ZipCodeRecordBuffer record;
+        std::string rendered;
+        bool referenced = false;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, size_t> slotOf;  ///< zip → index in entries
+        std::vector<Entry> entries;
+        size_t capacity = 0;
+        size_t hand = 0;                                 ///< CLOCK hand
+    };
+
+    const bool enabled;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+
+    Shard& shardFor(const std::string& zip);
+};
+
+#endif // HOT_RECORD_CACHE_H
@@ -19,25 +19,43 @@
 class IndexManager {
 private:
     std::map<std::string, uint64_t> indexMap;  ///< Maps ZIP code → file offset
+    bool hasDataFileStamp = false;             ///< Index names the data file it was built for
+    uint64_t dataFileSize = 0;                 ///< Size of that data file when the index was written
+    uint64_t dataFileHash = 0;                 ///< Its sampledFileHash() at the same point
 
 public:
     /**
      * @brief Builds the index from a binary data file.
      * @param dataFileName Path to the binary file (e.g., "Data/zip_len.dat").
+     * @return True if the data file and its header could be read.
      */
-    void buildIndex(const std::string& dataFileName);
+    bool buildIndex(const std::string& dataFileName);
 
     /**
      * @brief Writes the in-memory index to a binary file.
      * @param indexFileName Path to the output index file (e.g., "Data/zip.idx").
+     * @param dataFileName If given, the data file's current size and sampled hash
+     *                     are stored too, so belongsTo() can tell whose index it is.
+     *                     The data file must be fully written at this point.
+     * @return False if the index couldn't be written; the old file is then left as it was.
      */
-    void writeIndex(const std::string& indexFileName) const;
+    bool writeIndex(const std::string& indexFileName, const std::string& dataFileName = "");
 
     /**
      * @brief Loads the index from a binary file into memory.
      * @param indexFileName Path to the input index file.
+     * @return True if the index file could be opened and read completely.
      */
-    void readIndex(const std::string& indexFileName);
+    bool readIndex(const std::string& indexFileName);
+
+    /**
+     * @brief True if the loaded index was written for @p dataFileName as it is now.
+     *
+     * Every data file names the same index path by default, so an index on disk
+     * may belong to a different (older, newer, re-sorted) data file. Indexes without
+     * a data file stamp are never trusted.
+     */
+    bool belongsTo(const std::string& dataFileName) const;
 
     /**
      * @brief Finds the byte offset for a given ZIP code in the index.
@@ -46,6 +64,41 @@ public:
      */
     uint64_t findOffset(const std::string& zip) const;
 
+    /**
+     * @brief Finds how a ZIP code is spelled in the index. Keys keep the source
+     *        CSV's spelling, so "00501" may be stored as "501" or the other way round.
+     * @param zip The ZIP code to search for, with or without leading zeros.
+     * @param storedKey Set to the key as stored, if found.
+     * @return False if no spelling of the ZIP code is indexed.
+     */
+    bool findKey(const std::string& zip, std::string& storedKey) const;
+
+    /**
+     * @brief Adds a ZIP code or moves it to a new offset, without a rebuild.
+     * @param zip The ZIP code key.
+     * @param offset Byte offset of the record's length prefix in the data file.
+     */
+    void setOffset(const std::string& zip, uint64_t offset) { indexMap[zip] = offset; }
+
+    /**
+     * @brief Removes a ZIP code from the index.
+     * @return True if the ZIP code was present.
+     */
+    bool erase(const std::string& zip) { return indexMap.erase(zip) > 0; }
+
+    /**
+     * @brief Read-only access to every ZIP → offset entry, in key order.
+     */
+    const std::map<std::string, uint64_t>& entries() const { return indexMap; }
+
+    /**
+     * @brief Extracts the index key (the leading ZIP field) from a raw record.
+     * @param record A CSV record as stored in the data file.
+     * @param zip Receives the ZIP code.
+     * @return False if the leading field isn't a ZIP code (e.g. a header row or tombstone).
+     */
+    static bool recordKey(const std::string& record, std::string& zip);
+
     /**
      * @brief Returns the total number of entries in the index.
      * @return Number of indexed ZIP codes.
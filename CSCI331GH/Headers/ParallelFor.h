@@ -0,0 +1,38 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs fn(0) ... fn(count - 1) on a small pool of worker threads.
+ *
+ * Workers pull the next index from a shared counter, so uneven tasks (e.g.
+ * shards of different sizes) still balance. Returns once every call is done.
+ *
+ * @param count Number of tasks.
+ * @param fn Callable taking a size_t task index; must be safe to call concurrently.
+ * @param maxThreads Upper bound on workers (0 = hardware concurrency).
+ */
+template <typename Fn>
+void parallelFor(size_t count, Fn fn, unsigned maxThreads = 0) {
+    if (count == 0) return;
+
+    unsigned threads = maxThreads ? maxThreads : std::thread::hardware_concurrency();
+    threads = static_cast<unsigned>(std::min<size_t>(std::max(threads, 1u), count));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker(); // the calling thread works too
+    for (auto& thread : pool) thread.join();
+}
+
+#endif // PARALLEL_FOR_H
@@ -0,0 +1,75 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+/**
+ * @class ResultCache
+ * @brief Persists computed aggregates (reports) keyed by a fingerprint of the
+ *        data file they were computed from.
+ *
+ * The fingerprint is the file's size, modification time and a hash of its first
+ * block plus evenly spaced sample blocks, so checking it reads a few KB instead
+ * of the whole file. Aggregates are registered by name and only computed when
+ * first requested and missing from (or stale in) the cache file.
+ */
+class ResultCache {
+public:
+    /// Computes an aggregate's payload; returns false on failure (nothing is cached).
+    using Compute = std::function<bool(std::string& payload)>;
+
+    struct Fingerprint {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        uint64_t sampleHash = 0;
+
+        bool operator==(const Fingerprint& other) const {
+            return size == other.size && modified == other.modified && sampleHash == other.sampleHash;
+        }
+    };
+
+    /**
+     * @param sourceFileName Data file the aggregates are computed from.
+     * @param cacheFileName Where cached payloads are stored (e.g. "Data/report.cache").
+     */
+    ResultCache(const std::string& sourceFileName, const std::string& cacheFileName);
+
+    /**
+     * @brief Registers how to compute an aggregate; nothing runs until get().
+     */
+    void registerAggregate(const std::string& name, Compute compute);
+
+    /**
+     * @brief Returns an aggregate, from the cache when the source is unchanged,
+     *        otherwise by computing it and saving it to the cache file.
+     * @return False if the aggregate isn't registered or its computation failed.
+     */
+    bool get(const std::string& name, std::string& payload);
+
+    /**
+     * @brief Drops a cached payload (e.g. one the caller couldn't parse), so the
+     *        next get() recomputes it.
+     */
+    void discard(const std::string& name);
+
+    /**
+     * @brief Size, mtime and sampled-block hash of a file.
+     */
+    static bool fingerprintOf(const std::string& fileName, Fingerprint& fingerprint);
+
+private:
+    std::string sourceFileName;
+    std::string cacheFileName;
+    std::map<std::string, Compute> aggregates;
+    std::map<std::string, std::string> results;
+    Fingerprint sourceFingerprint;
+    bool loaded = false;
+
+    void load();
+    void save() const;
+};
+
+#endif // RESULT_CACHE_H
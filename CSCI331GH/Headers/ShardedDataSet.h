@@ -0,0 +1,116 @@
+#ifndef SHARDED_DATA_SET_H
+#define SHARDED_DATA_SET_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "IndexManager.h"
+#include "ParallelFor.h"
+#include "ZipCodeRecordBuffer.h"
+
+/**
+ * @struct ShardInfo
+ * @brief One manifest entry: the ZIP prefix a shard owns and where its files live.
+ */
+struct ShardInfo {
+    std::string prefix;         ///< Leading digit(s) of the 5-digit ZIP code
+    std::string dataFileName;
+    std::string indexFileName;
+    uint64_t recordCount = 0;
+};
+
+/**
+ * @class ShardedDataSet
+ * @brief ZIP data split into one data file + index per ZIP prefix.
+ *
+ * A text manifest lists the shards. Point lookups go straight to the shard that
+ * owns the ZIP prefix; range and aggregate queries run on every relevant shard
+ * in parallel and merge the per-shard results.
+ */
+class ShardedDataSet {
+public:
+    /**
+     * @brief Partitions a CSV file by ZIP prefix and writes the shards in parallel.
+     * @param inputCSVFileName Source CSV (first line is a header row).
+     * @param manifestFileName Manifest to create.
+     * @param prefixDigits 1 → up to 10 shards, 2 → up to 100 shards.
+     * @param shardDirectories Where shard files go, assigned round-robin (e.g. one
+     *                         per disk); empty puts them next to the manifest.
+     */
+    static bool build(const std::string& inputCSVFileName, const std::string& manifestFileName,
+                      int prefixDigits = 1, const std::vector<std::string>& shardDirectories = {});
+
+    /**
+     * @brief Reads a manifest and loads every shard's index.
+     */
+    bool open(const std::string& manifestFileName);
+
+    /**
+     * @brief Rewrites one opened shard from a CSV, leaving every other shard alone.
+     *
+     * Only the CSV lines whose ZIP has @p prefix are kept. The shard's index is
+     * reloaded and its record count updated in the manifest.
+     */
+    bool rebuildShard(const std::string& prefix, const std::string& inputCSVFileName);
+
+    /**
+     * @brief Reads the raw CSV record for a ZIP code from its shard.
+     * @param zip With or without leading zeros ("501" and "00501" are the same ZIP).
+     */
+    bool findRecord(const std::string& zip, std::string& record) const;
+
+    /**
+     * @brief All records with lowZip <= ZIP <= highZip, in ZIP order.
+     * @return False if a shard in the range couldn't be read; @p results then
+     *         holds only what the readable shards returned.
+     */
+    bool rangeQuery(uint32_t lowZip, uint32_t highZip, std::vector<std::string>& results) const;
+
+    /**
+     * @brief Folds every record into a per-shard Partial, in parallel, then merges them.
+     * @param total Receives the merged result.
+     * @param accumulate Called as accumulate(Partial&, const ZipCodeRecordBuffer&).
+     * @param merge Called as merge(Partial& total, const Partial& shardResult).
+     * @return False if any shard couldn't be read to the end, so @p total is incomplete.
+     */
+    template <typename Partial, typename Accumulate, typename Merge>
+    bool aggregate(Partial& total, Accumulate accumulate, Merge merge) const {
+        std::vector<Partial> partials(shards.size());
+        std::vector<char> ok(shards.size(), 0);
+        parallelFor(shards.size(), [&](size_t i) {
+            ok[i] = scanShard(i, [&](const ZipCodeRecordBuffer& record) { accumulate(partials[i], record); });
+        });
+
+        total = Partial{};
+        for (const auto& partial : partials) merge(total, partial);
+        for (char shardOk : ok) {
+            if (!shardOk) return false;
+        }
+        return true;
+    }
+
+    size_t shardCount() const { return shards.size(); }
+    const std::vector<ShardInfo>& shardList() const { return shards; }
+
+    /**
+     * @brief Zero-pads a ZIP code to 5 digits ("501" → "00501") for prefix routing.
+     */
+    static std::string paddedZip(const std::string& zip);
+
+private:
+    std::string manifestFileName;
+    int prefixDigits = 1;
+    std::vector<ShardInfo> shards;
+    std::vector<IndexManager> indexes;              ///< Parallel to shards
+    std::map<std::string, size_t> shardByPrefix;
+
+    bool scanShard(size_t shard, const std::function<void(const ZipCodeRecordBuffer&)>& visit) const;
+    static bool readRecordAt(std::ifstream& in, uint64_t offset, std::string& record);
+    static bool writeManifest(const std::string& manifestFileName, int prefixDigits,
+                              const std::vector<ShardInfo>& shards);
+};
+
+#endif // SHARDED_DATA_SET_H
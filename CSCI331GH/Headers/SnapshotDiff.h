@@ -0,0 +1,64 @@
+#ifndef SNAPSHOT_DIFF_H
+#define SNAPSHOT_DIFF_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class ZipCodeDataFile;
+
+/**
+ * @struct ChangeRecord
+ * @brief One entry of a changeset: a ZIP code that was added, changed or removed.
+ */
+struct ChangeRecord {
+    enum Op : char { ADDED = 'A', CHANGED = 'U', REMOVED = 'D' };
+
+    Op op = ADDED;
+    std::string zip;
+    std::string record;  ///< Normalized CSV line for ADDED/CHANGED, empty for REMOVED
+};
+
+/**
+ * @brief Compares two ZIP snapshots and lists the records that differ.
+ *
+ * Each side may be a CSV file (".csv") or a built binary data file. Records are
+ * parsed with ZipCodeRecordBuffer and hashed on their normalized fields in
+ * parallel, so formatting-only differences (quoting, spacing, extra columns,
+ * a RecordLength prefix) don't count as changes. Data files with a matching
+ * index (their own "<name>.idx", else the one named in their header) are read
+ * in key order through it and merge-joined; otherwise the two sides are
+ * hash-joined on ZIP code.
+ *
+ * @param oldSnapshot The baseline snapshot.
+ * @param newSnapshot The snapshot to compare against it.
+ * @param changes Receives the differences, ordered by ZIP code.
+ * @param mergeJoined If given, set to whether the merge join was used.
+ * @return False if either side could not be read.
+ */
+bool diffSnapshots(const std::string& oldSnapshot, const std::string& newSnapshot,
+                   std::vector<ChangeRecord>& changes, bool* mergeJoined = nullptr);
+
+/**
+ * @brief Writes / reads a changeset file.
+ *
+ * Format:
+ *   [magic:char[8]][count:uint32_t]
+ *   per change: [op:char][zipLen:uint16_t][zip][recordLen:uint32_t][record]
+ *   [crc32c of everything above:uint32_t]
+ */
+bool writeChangeset(const std::string& changesetFileName, const std::vector<ChangeRecord>& changes);
+bool readChangeset(const std::string& changesetFileName, std::vector<ChangeRecord>& changes);
+
+/**
+ * @brief Applies a changeset to an open data file (and its index) in place.
+ * @param onChanged Called with each ZIP code actually modified, spelled as its index
+ *                  key (which may have leading zeros), e.g. to
+ *                  invalidate that entry in a HotRecordCache.
+ * @return False if any change could not be applied.
+ */
+bool applyChangeset(const std::vector<ChangeRecord>& changes, ZipCodeDataFile& dataFile,
+                    const std::function<void(const std::string& zip)>& onChanged = nullptr);
+
+#endif // SNAPSHOT_DIFF_H
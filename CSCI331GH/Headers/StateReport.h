@@ -0,0 +1,43 @@
+#ifndef STATE_REPORT_H
+#define STATE_REPORT_H
+
+#include <limits>
+#include <map>
+#include <string>
+
+// Struct to hold the four extreme zip codes for each state
+struct StateRecord {
+    std::string easternmost_zip;
+    double easternmost_lon = -std::numeric_limits<double>::max();
+    std::string westernmost_zip;
+    double westernmost_lon = std::numeric_limits<double>::max();
+    std::string northernmost_zip;
+    double northernmost_lat = -std::numeric_limits<double>::max();
+    std::string southernmost_zip;
+    double southernmost_lat = std::numeric_limits<double>::max();
+};
+
+/**
+ * @brief Scans a CSV of ZIP records and finds each state's extreme ZIP codes.
+ * @param csvFileName e.g. "Data/converted_postal_codes.csv".
+ * @param states Receives one StateRecord per state, keyed by state code.
+ * @return False if the file can't be opened.
+ */
+bool computeStateExtremes(const std::string& csvFileName, std::map<std::string, StateRecord>& states);
+
+/**
+ * @brief Converts the report to/from the text payload stored in a ResultCache.
+ *
+ * Text fields are length-prefixed, so empty or space-containing values round-trip.
+ * deserializeStateExtremes() returns false (and leaves @p states empty) on a
+ * malformed payload.
+ */
+std::string serializeStateExtremes(const std::map<std::string, StateRecord>& states);
+bool deserializeStateExtremes(const std::string& payload, std::map<std::string, StateRecord>& states);
+
+/**
+ * @brief Prints the state extremes summary table.
+ */
+void printStateExtremes(const std::map<std::string, StateRecord>& states);
+
+#endif // STATE_REPORT_H
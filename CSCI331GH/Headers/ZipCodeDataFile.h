@@ -0,0 +1,144 @@
+#ifndef ZIP_CODE_DATA_FILE_H
+#define ZIP_CODE_DATA_FILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HeaderBuffer.h"
+#include "IndexManager.h"
+
+/**
+ * @class ZipCodeDataFile
+ * @brief Applies appends, updates and deletes to an existing length-indicated data
+ *        file and keeps its index in step, without rebuilding either.
+ *
+ * Deleted records become tombstones: the record body is overwritten with
+ * '*' followed by the 8-byte offset of the next deleted record, forming an
+ * avail list whose head lives in the (version 3) header. New or relocated
+ * records reuse the first tombstone that fits before growing the file.
+ *
+ * Once the share of dead bytes reaches the compaction threshold, a background
+ * thread rewrites the file with only the live records. It holds the lock only to
+ * copy the live records and, later, to swap the new file in; edits made while it
+ * writes make it give up, and the next edit past the threshold tries again.
+ *
+ * The block checksum sidecar is discarded before the first edit and rewritten
+ * on close() or compaction, so it never describes a file that has moved on.
+ */
+class ZipCodeDataFile {
+public:
+    static constexpr char TOMBSTONE = '*';
+    static constexpr uint64_t NO_RECORD = UINT64_MAX;
+
+    ZipCodeDataFile() = default;
+    ~ZipCodeDataFile();
+
+    ZipCodeDataFile(const ZipCodeDataFile&) = delete;
+    ZipCodeDataFile& operator=(const ZipCodeDataFile&) = delete;
+
+    /**
+     * @brief Opens a data file and loads (or builds) its index.
+     *
+     * Version 2 files are upgraded to version 3 by compacting them once.
+     */
+    bool open(const std::string& dataFileName);
+
+    /**
+     * @brief Writes the header and index back to disk and closes the file.
+     */
+    bool close();
+
+    /**
+     * @brief Adds a new record (a CSV line). Fails if its ZIP code already exists,
+     *        with or without leading zeros.
+     */
+    bool insert(const std::string& csvRecord);
+
+    /**
+     * @brief Replaces the record with the same ZIP code, in place if it fits.
+     */
+    bool update(const std::string& csvRecord);
+
+    /**
+     * @brief Tombstones the record for a ZIP code and adds it to the avail list.
+     */
+    bool remove(const std::string& zip);
+
+    /**
+     * @brief Reads the raw CSV record for a ZIP code.
+     *
+     * Like update() and remove(), this finds the key however the index spells it.
+     */
+    bool read(const std::string& zip, std::string& csvRecord);
+
+    /**
+     * @brief Finds how the index spells a ZIP code ("501" or "00501").
+     */
+    bool findKey(const std::string& zip, std::string& storedKey);
+
+    /**
+     * @brief Rewrites the file with only live records and refreshes the index.
+     */
+    bool compact();
+
+    /**
+     * @brief Dead bytes (tombstones) as a fraction of the record area.
+     */
+    double deadSpaceRatio();
+
+    /**
+     * @brief Ratio at which a background compaction is started (default 0.25).
+     *        Values above 1 disable automatic compaction.
+     */
+    void setCompactionThreshold(double ratio) { compactionThreshold = ratio; }
+
+    /**
+     * @brief Blocks until a running background compaction has finished.
+     */
+    void waitForCompaction();
+
+    /**
+     * @brief A copy of the current index, e.g. for ConcurrentIndex::publish().
+     */
+    IndexManager indexSnapshot();
+
+    uint64_t recordCount();
+
+private:
+    std::mutex fileMutex;  ///< Guards every member below against the compactor
+    std::fstream file;
+    std::string fileName;
+    HeaderRecordBuffer header;
+    IndexManager index;
+    uint64_t dataStart = 0;  ///< Offset of the first record, right after the header
+    uint64_t fileEnd = 0;
+    bool checksumsStale = false;  ///< Sidecar discarded by an edit, rewrite on close()
+    uint64_t editGeneration = 0;  ///< Bumped by every edit, so compaction can tell it raced one
+
+    double compactionThreshold = 0.25;
+    std::atomic<bool> compacting{false};
+    std::thread compactor;
+
+    bool openLocked(const std::string& dataFileName);
+    bool compactLocked();
+    bool reopenLocked();
+    bool collectLiveRecords(std::vector<std::string>& records);
+    static bool writeCompacted(const std::string& tempName, HeaderRecordBuffer newHeader,
+                               const std::vector<std::string>& records, IndexManager& newIndex);
+    bool swapInCompacted(const std::string& tempName, const IndexManager& newIndex);
+    bool writeRecordAt(uint64_t offset, uint32_t slotLength, const std::string& record);
+    bool placeRecord(const std::string& record, uint64_t& offset);
+    bool takeFromAvailList(uint32_t needed, uint64_t& offset, uint32_t& slotLength);
+    bool tombstone(uint64_t offset);
+    bool beginEdit();
+    void flushHeader();
+    void maybeCompact();
+    static bool parseZip(const std::string& csvRecord, std::string& zip);
+};
+
+#endif // ZIP_CODE_DATA_FILE_H
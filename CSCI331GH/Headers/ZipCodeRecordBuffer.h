@@ -49,12 +49,15 @@ public:
             }
             bool hasRecordLength = false;
             // Detect optional RecordLength field: treat as numeric integer (all digits)
+            // followed by a numeric ZIP; a trailing extra column (e.g. "RAND #s") is not one
             if (fields.size() == 7) {
+                auto allDigits = [](const std::string &f) {
+                    return !f.empty() && std::all_of(f.begin(), f.end(), [](unsigned char c){
+                        return std::isdigit(c);
+                    });
+                };
                 const std::string &f0 = fields[0];
-                bool allDigits = !f0.empty() && std::all_of(f0.begin(), f0.end(), [](unsigned char c){
-                    return std::isdigit(c);
-                });
-                if (allDigits) hasRecordLength = true;
+                if (allDigits(f0) && allDigits(fields[1])) hasRecordLength = true;
                 else {
                     // maybe header with "RecordLength" text: skip header
                     std::string up0 = f0;
@@ -7,8 +7,12 @@
 #include <string>
 
 void lenRead(std::ofstream& output, const std::string& record);
-void processFile(std::string& inputFileName, const std::string& outputFileName);
-void binaryToCSV();
+// sortMemoryBudget > 0 writes the records in ZIP order via an external merge sort
+// that uses roughly that many bytes of memory (see ExternalSort.h)
+void processFile(std::string& inputFileName, const std::string& outputFileName,
+                 size_t sortMemoryBudget = 0);
+void binaryToCSV(const std::string& inputCSVFileName = "Data/us_postal_codes.csv",
+                 size_t sortMemoryBudget = 0);
 
 
 
@@ -7,7 +7,8 @@
 #include <string>
 
 void lenRead(std::ofstream& output, const std::string& record);
-void processFile(std::string& inputFileName, const std::string& outputFileName);
+void processFile(std::string& inputFileName, const std::string& outputFileName,
+                 size_t sortMemoryBudget);
 
 
 
@@ -0,0 +1,450 @@
+#include "AsyncRecordFetcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define ZIP_HAVE_IO_URING 1
+        #include <linux/io_uring.h>
+        #include <sys/mman.h>
+        #include <sys/syscall.h>
+        #include <cerrno>
+    #endif
+#endif
+
+// ---------------------------------------------------------------------------
+// Plain positional read, used by the thread pool and for io_uring retries
+// ---------------------------------------------------------------------------
+
+#ifdef _WIN32
+/**
+ * @brief No pread on Windows: each worker thread keeps its own stream instead.
+ */
+static long readAt(const std::string& fileName, int, uint64_t offset, char* buffer, size_t length) {
+    thread_local std::string openName;
+    thread_local std::ifstream in;
+    if (openName != fileName) {
+        in.close();
+        in.open(fileName, std::ios::binary);
+        openName = fileName;
+    }
+    in.clear();
+    in.seekg(offset, std::ios::beg);
+    in.read(buffer, length);
+    return static_cast<long>(in.gcount());
+}
+#else
+static long readAt(const std::string&, int fd, uint64_t offset, char* buffer, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t got = ::pread(fd, buffer + done, length - done, static_cast<off_t>(offset + done));
+        if (got <= 0) break;
+        done += static_cast<size_t>(got);
+    }
+    return static_cast<long>(done);
+}
+#endif
+
+bool AsyncRecordFetcher::refreshFileSize() {
+#ifdef _WIN32
+    std::ifstream in(fileName, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    fileSize = static_cast<uint64_t>(in.tellg());
+#else
+    struct stat info;
+    if (::fstat(fd, &info) != 0) return false;
+    fileSize = static_cast<uint64_t>(info.st_size);
+#endif
+    return true;
+}
+
+/**
+ * @brief True if [length][record] at @p offset lies entirely inside the file.
+ */
+bool AsyncRecordFetcher::recordFits(uint64_t offset, uint32_t recordLength) const {
+    return offset <= fileSize && fileSize - offset >= sizeof(recordLength)
+        && recordLength <= fileSize - offset - sizeof(recordLength);
+}
+
+bool AsyncRecordFetcher::readRecordAt(uint64_t offset, std::string& record) const {
+    uint32_t recordLength = 0;
+    if (readAt(fileName, fd, offset, reinterpret_cast<char*>(&recordLength), sizeof(recordLength))
+        != static_cast<long>(sizeof(recordLength))) {
+        return false;
+    }
+    // Never allocate for a length the file can't hold (corrupt prefix, stale offset)
+    if (!recordFits(offset, recordLength)) return false;
+    record.assign(recordLength, '\0');
+    return recordLength == 0
+        || readAt(fileName, fd, offset + sizeof(recordLength), &record[0], recordLength) == static_cast<long>(recordLength);
+}
+
+// ---------------------------------------------------------------------------
+// io_uring (Linux): submission/completion rings mapped from the kernel
+// ---------------------------------------------------------------------------
+
+#ifdef ZIP_HAVE_IO_URING
+
+struct AsyncRecordFetcher::Ring {
+    int ringFd = -1;
+    unsigned entries = 0;
+
+    void* sqMap = nullptr;
+    size_t sqMapSize = 0;
+    void* cqMap = nullptr;
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    bool setup(unsigned depth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+        if (ringFd < 0) return false;
+        entries = params.sq_entries;
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED) { sqMap = nullptr; return false; }
+        if (singleMap) {
+            cqMap = sqMap;
+        } else {
+            cqMap = mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (cqMap == MAP_FAILED) { cqMap = nullptr; return false; }
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) return false;
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+        char* sq = static_cast<char*>(sqMap);
+        char* cq = static_cast<char*>(cqMap);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~Ring() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqMap && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap) munmap(sqMap, sqMapSize);
+        if (ringFd >= 0) close(ringFd);
+    }
+
+    /// Queues one read; the caller never has more than `entries` outstanding.
+    void queueRead(int fd, uint64_t offset, char* buffer, unsigned length, uint64_t userData) {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->off = offset;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = length;
+        sqe->user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /// Submits every queued read and waits for at least one completion. The kernel
+    /// may accept only part of the queue, so @p toSubmit is decremented by what went
+    /// in and the rest is resubmitted; on failure it holds what is still queued.
+    bool submitAndWait(unsigned& toSubmit) {
+        while (true) {
+            long ret = syscall(__NR_io_uring_enter, ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            unsigned submitted = static_cast<unsigned>(ret);
+            if (submitted >= toSubmit) {
+                toSubmit = 0;
+                return true;
+            }
+            if (submitted == 0) return false; // no progress: the rest can never go in
+            toSubmit -= submitted;
+        }
+    }
+
+    /// Waits until @p outstanding completions have arrived, discarding them.
+    bool drain(size_t outstanding) {
+        while (outstanding > 0) {
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail && outstanding > 0; ++head) --outstanding;
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            if (outstanding == 0) break;
+
+            long ret = syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0 && errno != EINTR) return false;
+        }
+        return true;
+    }
+};
+
+AsyncRecordFetcher::AsyncRecordFetcher(const std::string& dataFileName, unsigned depth)
+    : fileName(dataFileName), queueDepth(std::max(1u, depth)) {
+    fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open " << fileName << " for reading.\n";
+        return;
+    }
+
+    ring = new Ring();
+    if (!ring->setup(queueDepth)) {
+        delete ring; // io_uring unavailable: use the thread pool
+        ring = nullptr;
+    }
+}
+
+AsyncRecordFetcher::~AsyncRecordFetcher() {
+    delete ring;
+    if (fd >= 0) ::close(fd);
+}
+
+/**
+ * @brief Keeps up to queueDepth reads in flight on the ring, reaping completions
+ *        as they arrive and refilling the queue after each wait.
+ */
+bool AsyncRecordFetcher::fetchWithRing(const std::vector<uint64_t>& offsets, const Callback& onRecord) {
+    struct Slot {
+        size_t batchIndex = 0;
+        uint64_t received = 0;   ///< Bytes of [length][record] read so far
+        std::vector<char> buffer;
+    };
+
+    const unsigned depth = std::min<unsigned>(queueDepth, ring->entries);
+    // On the heap so the buffers can be abandoned if in-flight reads can't be waited out
+    std::unique_ptr<std::vector<Slot>> slotStore(new std::vector<Slot>(depth));
+    std::vector<Slot>& slots = *slotStore;
+    std::vector<unsigned> freeSlots;
+    for (unsigned s = depth; s-- > 0; ) freeSlots.push_back(s);
+
+    size_t next = 0;
+    size_t inFlight = 0;
+    unsigned toSubmit = 0;
+    bool allOk = true;
+
+    auto failRetry = [&](Slot& slot) {
+        // Fall back to a synchronous read for this record (e.g. old kernel without IORING_OP_READ)
+        std::string record;
+        if (readRecordAt(offsets[slot.batchIndex], record)) {
+            onRecord(slot.batchIndex, record);
+        } else {
+            std::cerr << "Error reading record at offset " << offsets[slot.batchIndex] << ".\n";
+            allOk = false;
+        }
+    };
+
+    while (next < offsets.size() || inFlight > 0) {
+        while (!freeSlots.empty() && next < offsets.size()) {
+            unsigned s = freeSlots.back();
+            freeSlots.pop_back();
+            Slot& slot = slots[s];
+            slot.batchIndex = next++;
+            slot.received = 0;
+            slot.buffer.resize(FIRST_READ_SIZE);
+            ring->queueRead(fd, offsets[slot.batchIndex], slot.buffer.data(), FIRST_READ_SIZE, s);
+            ++inFlight;
+            ++toSubmit;
+        }
+
+        if (!ring->submitAndWait(toSubmit)) {
+            std::cerr << "Error: io_uring_enter failed; switching to the thread pool.\n";
+            // Reads the kernel already accepted still target the slot buffers: wait for
+            // them before the ring goes away. Closing the ring doesn't wait, so if even
+            // that fails the ring and buffers are leaked rather than freed under it.
+            if (ring->drain(inFlight - toSubmit)) {
+                delete ring;
+            } else {
+                slotStore.release();
+            }
+            ring = nullptr;
+            for (unsigned s = 0; s < depth; ++s) {
+                if (std::find(freeSlots.begin(), freeSlots.end(), s) == freeSlots.end()) failRetry(slots[s]);
+            }
+            std::vector<uint64_t> rest(offsets.begin() + next, offsets.end());
+            bool ok = fetchWithThreads(rest, [&](size_t i, const std::string& record) {
+                onRecord(next + i, record);
+            });
+            return allOk && ok;
+        }
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = ring->cqes[head & *ring->cqMask];
+            unsigned s = static_cast<unsigned>(cqe.user_data);
+            Slot& slot = slots[s];
+            bool done = true;
+
+            if (cqe.res < 0) {
+                failRetry(slot);
+            } else {
+                slot.received += static_cast<uint64_t>(cqe.res);
+                uint32_t recordLength = 0;
+                if (slot.received >= sizeof(recordLength)) {
+                    std::memcpy(&recordLength, slot.buffer.data(), sizeof(recordLength));
+                }
+                if (slot.received < sizeof(recordLength)) {
+                    std::cerr << "Error: short read at offset " << offsets[slot.batchIndex] << ".\n";
+                    allOk = false;
+                } else if (!recordFits(offsets[slot.batchIndex], recordLength)) {
+                    std::cerr << "Error: corrupt record length " << recordLength << " at offset "
+                              << offsets[slot.batchIndex] << ".\n";
+                    allOk = false;
+                } else {
+                    uint64_t total = sizeof(recordLength) + static_cast<uint64_t>(recordLength);
+                    if (slot.received >= total) {
+                        onRecord(slot.batchIndex, std::string(slot.buffer.data() + sizeof(recordLength), recordLength));
+                    } else if (cqe.res == 0) {
+                        std::cerr << "Error: record at offset " << offsets[slot.batchIndex] << " is truncated.\n";
+                        allOk = false;
+                    } else {
+                        // Long record: read the remainder into the same slot
+                        slot.buffer.resize(total);
+                        ring->queueRead(fd, offsets[slot.batchIndex] + slot.received, slot.buffer.data() + slot.received,
+                                        static_cast<unsigned>(total - slot.received), s);
+                        ++toSubmit;
+                        done = false;
+                    }
+                }
+            }
+
+            if (done) {
+                freeSlots.push_back(s);
+                --inFlight;
+            }
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+    return allOk;
+}
+
+#else // !ZIP_HAVE_IO_URING
+
+struct AsyncRecordFetcher::Ring {};
+
+AsyncRecordFetcher::AsyncRecordFetcher(const std::string& dataFileName, unsigned depth)
+    : fileName(dataFileName), queueDepth(std::max(1u, depth)) {
+#ifdef _WIN32
+    std::ifstream probe(fileName, std::ios::binary);
+    fd = probe.is_open() ? 0 : -1;
+#else
+    fd = ::open(fileName.c_str(), O_RDONLY);
+#endif
+    if (fd < 0) std::cerr << "Error: Cannot open " << fileName << " for reading.\n";
+}
+
+AsyncRecordFetcher::~AsyncRecordFetcher() {
+#ifndef _WIN32
+    if (fd >= 0) ::close(fd);
+#endif
+}
+
+bool AsyncRecordFetcher::fetchWithRing(const std::vector<uint64_t>& offsets, const Callback& onRecord) {
+    return fetchWithThreads(offsets, onRecord);
+}
+
+#endif // ZIP_HAVE_IO_URING
+
+// ---------------------------------------------------------------------------
+// Thread-pool fallback: queueDepth workers doing blocking reads
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Workers read records in parallel and hand them to the calling thread,
+ *        which runs the callback, so callbacks never need to be thread-safe.
+ */
+bool AsyncRecordFetcher::fetchWithThreads(const std::vector<uint64_t>& offsets, const Callback& onRecord) {
+    std::mutex queueMutex;
+    std::condition_variable ready;
+    std::deque<std::pair<size_t, std::string>> completed;
+    size_t finished = 0;             // records read or failed, guarded by queueMutex
+    std::atomic<size_t> next(0);
+    std::atomic<bool> allOk(true);
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < offsets.size(); i = next++) {
+            std::string record;
+            bool ok = readRecordAt(offsets[i], record);
+            if (!ok) {
+                std::cerr << "Error reading record at offset " << offsets[i] << ".\n";
+                allOk = false;
+            }
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (ok) completed.emplace_back(i, std::move(record));
+                ++finished;
+            }
+            ready.notify_one();
+        }
+    };
+
+    size_t workers = std::min<size_t>(queueDepth, offsets.size());
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < workers; ++t) pool.emplace_back(worker);
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        ready.wait(lock, [&]() { return !completed.empty() || finished == offsets.size(); });
+        if (completed.empty()) break; // everything read and delivered
+
+        std::pair<size_t, std::string> item = std::move(completed.front());
+        completed.pop_front();
+        lock.unlock();
+
+        onRecord(item.first, item.second);
+    }
+
+    for (auto& thread : pool) thread.join();
+    return allOk;
+}
+
+bool AsyncRecordFetcher::fetchBatch(const std::vector<uint64_t>& offsets, const Callback& onRecord) {
+    if (fd < 0) return false;
+    if (offsets.empty()) return true;
+    if (!refreshFileSize()) {
+        std::cerr << "Error: Cannot get the size of " << fileName << ".\n";
+        return false;
+    }
+    return ring ? fetchWithRing(offsets, onRecord) : fetchWithThreads(offsets, onRecord);
+}
@@ -0,0 +1,196 @@
+#include "BlockChecksums.h"
+#include "FileReplace.h"
+#include "Crc32c.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+static const char SIDECAR_MAGIC[8] = {'Z', 'I', 'P', 'C', 'R', 'C', '3', '2'};
+static const size_t READ_CHUNK_BLOCKS = 16;  // blocks per sequential read
+
+/**
+ * @brief Splits the file into one contiguous run of blocks per worker; each worker
+ *        streams its run with large reads and checksums block by block.
+ */
+bool BlockChecksums::checksumFile(const std::string& dataFileName, uint32_t blockSize,
+                                  uint64_t& length, std::vector<uint32_t>& crcs) {
+    std::error_code error;
+    length = std::filesystem::file_size(dataFileName, error);
+    if (error) {
+        std::cerr << "Error: Cannot stat " << dataFileName << ".\n";
+        return false;
+    }
+
+    uint64_t blockCount = (length + blockSize - 1) / blockSize;
+    crcs.assign(blockCount, 0);
+
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = static_cast<size_t>(std::min<uint64_t>(workers, std::max<uint64_t>(blockCount, 1)));
+    uint64_t perWorker = (blockCount + workers - 1) / workers;
+    std::atomic<bool> ok(true);
+
+    parallelFor(workers, [&](size_t w) {
+        uint64_t first = w * perWorker;
+        uint64_t last = std::min(blockCount, first + perWorker);
+        if (first >= last) return;
+
+        std::ifstream in(dataFileName, std::ios::binary);
+        if (!in.is_open()) {
+            ok = false;
+            return;
+        }
+        in.seekg(first * blockSize, std::ios::beg);
+
+        std::vector<char> buffer(static_cast<size_t>(blockSize) * READ_CHUNK_BLOCKS);
+        for (uint64_t block = first; block < last; ) {
+            uint64_t count = std::min<uint64_t>(READ_CHUNK_BLOCKS, last - block);
+            uint64_t bytes = std::min<uint64_t>(count * blockSize, length - block * blockSize);
+            if (!in.read(buffer.data(), static_cast<std::streamsize>(bytes))) {
+                ok = false;
+                return;
+            }
+            for (uint64_t b = 0; b < count; ++b) {
+                uint64_t start = b * blockSize;
+                uint64_t size = std::min<uint64_t>(blockSize, bytes - start);
+                crcs[block + b] = crc32c(buffer.data() + start, static_cast<size_t>(size));
+            }
+            block += count;
+        }
+    }, static_cast<unsigned>(workers));
+
+    if (!ok) std::cerr << "Error reading " << dataFileName << " for checksumming.\n";
+    return ok;
+}
+
+bool BlockChecksums::write(const std::string& dataFileName, uint32_t blockSize) {
+    uint64_t length = 0;
+    std::vector<uint32_t> crcs;
+    if (!checksumFile(dataFileName, blockSize, length, crcs)) return false;
+
+    std::ostringstream body(std::ios::binary);
+    uint64_t blockCount = crcs.size();
+    body.write(SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+    body.write(reinterpret_cast<const char*>(&blockSize), sizeof(blockSize));
+    body.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    body.write(reinterpret_cast<const char*>(&blockCount), sizeof(blockCount));
+    body.write(reinterpret_cast<const char*>(crcs.data()), crcs.size() * sizeof(uint32_t));
+
+    const std::string bytes = body.str();
+    uint32_t trailer = crc32c(bytes.data(), bytes.size());
+
+    // Write a temp file and rename it over the old sidecar, so a crash mid-write
+    // leaves either the old sidecar or the new one, never a torn mix
+    std::string name = sidecarName(dataFileName);
+    std::string tempName = name + ".tmp";
+    std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+    out.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Cannot write " << tempName << ".\n";
+        std::remove(tempName.c_str());
+        return false;
+    }
+
+    if (!replaceFile(tempName, name)) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool BlockChecksums::discard(const std::string& dataFileName) {
+    std::string name = sidecarName(dataFileName);
+    std::error_code error;
+    std::filesystem::remove(name, error);
+    if (error) {
+        std::cerr << "Error: Cannot remove stale " << name << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool BlockChecksums::load(const std::string& dataFileName) {
+    blockSize = 0;
+    std::string name = sidecarName(dataFileName);
+    std::ifstream in(name, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const size_t fixedSize = sizeof(SIDECAR_MAGIC) + sizeof(uint32_t) + 2 * sizeof(uint64_t);
+    if (bytes.size() < fixedSize + sizeof(uint32_t)
+        || !std::equal(SIDECAR_MAGIC, SIDECAR_MAGIC + sizeof(SIDECAR_MAGIC), bytes.begin())) {
+        std::cerr << "Error: " << name << " is not a checksum file.\n";
+        return false;
+    }
+
+    uint32_t trailer = 0;
+    std::copy(bytes.end() - sizeof(trailer), bytes.end(), reinterpret_cast<char*>(&trailer));
+    if (crc32c(bytes.data(), bytes.size() - sizeof(trailer)) != trailer) {
+        std::cerr << "Error: " << name << " is corrupt (trailer checksum mismatch).\n";
+        return false;
+    }
+
+    const char* p = bytes.data() + sizeof(SIDECAR_MAGIC);
+    uint32_t size = 0;
+    uint64_t blockCount = 0;
+    std::copy(p, p + sizeof(size), reinterpret_cast<char*>(&size));
+    p += sizeof(size);
+    std::copy(p, p + sizeof(dataLength), reinterpret_cast<char*>(&dataLength));
+    p += sizeof(dataLength);
+    std::copy(p, p + sizeof(blockCount), reinterpret_cast<char*>(&blockCount));
+    p += sizeof(blockCount);
+
+    if (size == 0 || bytes.size() != fixedSize + blockCount * sizeof(uint32_t) + sizeof(trailer)) {
+        std::cerr << "Error: " << name << " has an inconsistent block count.\n";
+        return false;
+    }
+    blockCrcs.resize(blockCount);
+    std::copy(p, p + blockCount * sizeof(uint32_t), reinterpret_cast<char*>(blockCrcs.data()));
+    blockSize = size;
+    return true;
+}
+
+bool BlockChecksums::verifyFile(const std::string& dataFileName) const {
+    uint64_t length = 0;
+    std::vector<uint32_t> crcs;
+    if (!checksumFile(dataFileName, blockSize, length, crcs)) return false;
+
+    bool ok = true;
+    if (length != dataLength) {
+        std::cerr << dataFileName << ": size is " << length << " bytes, expected " << dataLength
+                  << (length < dataLength ? " (truncated).\n" : ".\n");
+        ok = false;
+    }
+    for (size_t block = 0; block < std::min(crcs.size(), blockCrcs.size()); ++block) {
+        if (crcs[block] != blockCrcs[block]) {
+            std::cerr << dataFileName << ": block " << block << " (offset "
+                      << static_cast<uint64_t>(block) * blockSize << ") checksum mismatch.\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool BlockChecksums::verifyRange(std::istream& data, uint64_t offset, uint64_t length) const {
+    if (!isLoaded() || length == 0) return isLoaded();
+    if (offset + length > dataLength) return false;
+
+    std::vector<char> buffer(blockSize);
+    for (uint64_t block = offset / blockSize; block <= (offset + length - 1) / blockSize; ++block) {
+        uint64_t start = block * blockSize;
+        uint64_t size = std::min<uint64_t>(blockSize, dataLength - start);
+        data.clear();
+        data.seekg(start, std::ios::beg);
+        if (!data.read(buffer.data(), static_cast<std::streamsize>(size))) return false;
+        if (crc32c(buffer.data(), static_cast<size_t>(size)) != blockCrcs[block]) return false;
+    }
+    return true;
+}
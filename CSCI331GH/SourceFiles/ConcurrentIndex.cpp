@@ -0,0 +1,153 @@
+#include "ConcurrentIndex.h"
+
+static std::atomic<uint64_t> nextInstanceId(1);
+
+/**
+ * @brief The reader record this thread used last, tried first on its next acquire().
+ */
+struct ReaderHint {
+    uint64_t instanceId = 0;
+    void* record = nullptr;
+};
+static thread_local ReaderHint readerHint;
+
+/**
+ * @brief Starts with no snapshot; epoch 0 is reserved to mark an idle reader record.
+ */
+ConcurrentIndex::ConcurrentIndex()
+    : instanceId(nextInstanceId++), current(nullptr), globalEpoch(1), readers(nullptr) {}
+
+/**
+ * @brief Frees the live and all retired snapshots and the reader records.
+ *        No readers may be active.
+ */
+ConcurrentIndex::~ConcurrentIndex() {
+    delete current.load();
+    for (auto& entry : retired) delete entry.second;
+    for (ReaderRecord* record = readers.load(); record; ) {
+        ReaderRecord* next = record->next;
+        delete record;
+        record = next;
+    }
+}
+
+/**
+ * @brief Claims an idle reader record, stamps it with the current epoch, then loads
+ * the snapshot pointer.
+ *
+ * The record is stamped BEFORE the pointer is loaded, so a writer that sees it
+ * idle (or doesn't see it at all yet) is guaranteed the reader will pick up the
+ * newer snapshot. If every record is busy a new one is added rather than waiting.
+ */
+ConcurrentIndex::ReadGuard ConcurrentIndex::acquire() const {
+    uint64_t epoch = globalEpoch.load();
+    uint64_t idle = 0;
+
+    if (readerHint.instanceId == instanceId) {
+        ReaderRecord* hinted = static_cast<ReaderRecord*>(readerHint.record);
+        if (hinted->epoch.compare_exchange_strong(idle, epoch)) {
+            return ReadGuard(this, hinted, current.load());
+        }
+    }
+
+    for (ReaderRecord* record = readers.load(); record; record = record->next) {
+        idle = 0;
+        if (record->epoch.compare_exchange_strong(idle, epoch)) {
+            readerHint.instanceId = instanceId;
+            readerHint.record = record;
+            return ReadGuard(this, record, current.load());
+        }
+    }
+
+    ReaderRecord* record = new ReaderRecord();
+    record->epoch.store(epoch);
+    ReaderRecord* head = readers.load();
+    do {
+        record->next = head;
+    } while (!readers.compare_exchange_weak(head, record));
+
+    readerHint.instanceId = instanceId;
+    readerHint.record = record;
+    return ReadGuard(this, record, current.load());
+}
+
+/**
+ * @brief Marks a reader record idle. If snapshots are waiting to be freed, the
+ *        leaving reader reclaims them unless a writer is busy (it never waits).
+ */
+void ConcurrentIndex::release(ReaderRecord* record) const {
+    record->epoch.store(0);
+    if (retiredCount.load() == 0) return;
+
+    std::unique_lock<std::mutex> lock(writerMutex, std::try_to_lock);
+    if (lock.owns_lock()) reclaim();
+}
+
+/**
+ * @brief Looks up a ZIP code in whatever snapshot is current right now.
+ */
+uint64_t ConcurrentIndex::findOffset(const std::string& zip) const {
+    ReadGuard guard = acquire();
+    return guard ? guard->findOffset(zip) : UINT64_MAX;
+}
+
+size_t ConcurrentIndex::size() const {
+    ReadGuard guard = acquire();
+    return guard ? guard->size() : 0;
+}
+
+/**
+ * @brief Swaps in a new snapshot and retires the old one under the next epoch.
+ */
+void ConcurrentIndex::publish(std::unique_ptr<IndexManager> next) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+
+    const IndexManager* old = current.exchange(next.release());
+    uint64_t retireEpoch = globalEpoch.fetch_add(1) + 1;
+
+    if (old) {
+        retired.emplace_back(retireEpoch, old);
+        retiredCount.store(retired.size());
+    }
+    reclaim();
+}
+
+/**
+ * @brief Deletes retired snapshots that no active reader can still be holding.
+ *
+ * A reader stamped with epoch E loaded the pointer after the epoch reached E, so it
+ * can only see snapshots retired after E. Anything retired at or before the oldest
+ * active reader's epoch is unreachable. Caller must hold writerMutex.
+ */
+void ConcurrentIndex::reclaim() const {
+    uint64_t oldestActive = UINT64_MAX;
+    for (const ReaderRecord* record = readers.load(); record; record = record->next) {
+        uint64_t epoch = record->epoch.load();
+        if (epoch != 0 && epoch < oldestActive) oldestActive = epoch;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); ++i) {
+        if (retired[i].first <= oldestActive) {
+            delete retired[i].second;
+        } else {
+            retired[kept++] = retired[i];
+        }
+    }
+    retired.resize(kept);
+    retiredCount.store(kept);
+}
+
+bool ConcurrentIndex::reloadFromIndexFile(const std::string& indexFileName) {
+    std::unique_ptr<IndexManager> next(new IndexManager());
+    if (!next->readIndex(indexFileName)) return false;
+    publish(std::move(next));
+    return true;
+}
+
+bool ConcurrentIndex::rebuildFromDataFile(const std::string& dataFileName) {
+    std::unique_ptr<IndexManager> next(new IndexManager());
+    if (!next->buildIndex(dataFileName)) return false;
+    publish(std::move(next));
+    return true;
+}
@@ -0,0 +1,134 @@
+#include "Crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define CRC32C_X86 1
+    #include <nmmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#elif defined(__ARM_FEATURE_CRC32)
+    #define CRC32C_ARM 1
+    #include <arm_acle.h>
+#endif
+
+static const uint32_t CASTAGNOLI_POLY = 0x82F63B78; // reflected
+
+// ---------------------------------------------------------------------------
+// Software path: slicing-by-8 (eight bytes per step through 8 tables)
+// ---------------------------------------------------------------------------
+
+struct SlicingTables {
+    uint32_t table[8][256];
+
+    SlicingTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (CASTAGNOLI_POLY & (0u - (crc & 1)));
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int t = 1; t < 8; ++t) table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+        }
+    }
+};
+
+static const SlicingTables tables;
+
+static uint32_t crc32cSoftware(const unsigned char* p, size_t length, uint32_t crc) {
+    const auto& t = tables.table;
+    while (length >= 8) {
+        uint32_t low, high;
+        std::memcpy(&low, p, 4);
+        std::memcpy(&high, p + 4, 4);
+        low ^= crc; // assumes little-endian, like the rest of the file formats
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+            ^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+// ---------------------------------------------------------------------------
+// Hardware paths
+// ---------------------------------------------------------------------------
+
+#if defined(CRC32C_X86)
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("sse4.2")))
+#endif
+static uint32_t crc32cHardware(const unsigned char* p, size_t length, uint32_t crc) {
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        length -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (length >= 4) {
+        uint32_t word;
+        std::memcpy(&word, p, 4);
+        crc = _mm_crc32_u32(crc, word);
+        p += 4;
+        length -= 4;
+    }
+    while (length--) crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+
+static bool detectHardware() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0; // ECX bit 20 = SSE4.2
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+#elif defined(CRC32C_ARM)
+
+static uint32_t crc32cHardware(const unsigned char* p, size_t length, uint32_t crc) {
+    while (length >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+        p += 8;
+        length -= 8;
+    }
+    while (length--) crc = __crc32cb(crc, *p++);
+    return crc;
+}
+
+static bool detectHardware() { return true; } // compiled for a CPU with the CRC extension
+
+#else
+
+static uint32_t crc32cHardware(const unsigned char* p, size_t length, uint32_t crc) {
+    return crc32cSoftware(p, length, crc);
+}
+
+static bool detectHardware() { return false; }
+
+#endif
+
+static const bool useHardware = detectHardware();
+
+bool crc32cIsHardwareAccelerated() {
+    return useHardware;
+}
+
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    crc = useHardware ? crc32cHardware(p, length, crc) : crc32cSoftware(p, length, crc);
+    return ~crc;
+}
@@ -0,0 +1,73 @@
+#include "DataFileWriter.h"
+#include "BlockChecksums.h"
+#include "FileReplace.h"
+
+#include <cstdio>
+#include <iostream>
+
+bool DataFileWriter::open(const std::string& dataFileName, const std::string& indexFileName,
+                          size_t bufferBytes) {
+    fileName = dataFileName;
+    tempName = dataFileName + ".tmp";
+    if (bufferBytes > 0) {
+        // Large sequential writes; the buffer has to be installed before open()
+        streamBuffer.resize(bufferBytes);
+        out.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+    }
+    out.open(tempName, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open " << tempName << " for writing.\n";
+        return false;
+    }
+
+    header = HeaderRecordBuffer();
+    header.version = 3;
+    header.indexFileName = indexFileName;
+    header.primaryKeyFieldIndex = 0;
+
+    header.fields.push_back({"ZipCode", DataType::STRING});
+    header.fields.push_back({"PlaceName", DataType::STRING});
+    header.fields.push_back({"State", DataType::STRING});
+    header.fields.push_back({"County", DataType::STRING});
+    header.fields.push_back({"Latitude", DataType::DOUBLE});
+    header.fields.push_back({"Longitude", DataType::DOUBLE});
+
+    indexManager = IndexManager();
+    header.writeHeader(out);
+    return static_cast<bool>(out);
+}
+
+bool DataFileWriter::append(const std::string& record) {
+    uint64_t offset = static_cast<uint64_t>(out.tellp());
+
+    uint32_t recordLength = static_cast<uint32_t>(record.length());
+    out.write(reinterpret_cast<const char*>(&recordLength), sizeof(recordLength)); // length prefix (uint32_t)
+    out.write(record.c_str(), recordLength);
+
+    std::string zip;
+    if (IndexManager::recordKey(record, zip)) {
+        indexManager.setOffset(zip, offset);
+    }
+    ++header.recordCount;
+    return static_cast<bool>(out);
+}
+
+bool DataFileWriter::close() {
+    // Header size doesn't depend on the record count, so it can be patched in place
+    out.seekp(0, std::ios::beg);
+    header.rewriteHeader(out);
+    out.close();
+    if (!out) {
+        std::cerr << "Error writing " << tempName << ".\n";
+        std::remove(tempName.c_str());
+        return false;
+    }
+
+    // Swap the finished file in; the old sidecar goes first so it never describes the new file
+    if (!BlockChecksums::discard(fileName) || !replaceFile(tempName, fileName)) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    if (!indexManager.writeIndex(header.indexFileName, fileName)) return false;
+    return BlockChecksums::write(fileName);
+}
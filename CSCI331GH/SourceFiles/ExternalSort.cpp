@@ -0,0 +1,273 @@
+#include "ExternalSort.h"
+#include "DataFileWriter.h"
+#include "IndexManager.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Run files use the same [length:uint32_t][record] layout as the data file body
+
+using SortEntry = std::pair<uint32_t, std::string>;
+/// A deque rather than a vector: growing it never holds two copies of the chunk
+using SortChunk = std::deque<SortEntry>;
+
+/// Memory a buffered record costs beyond its text: its deque slot, its slot in
+/// stable_sort's scratch buffer and the string's heap block header
+static const size_t ENTRY_OVERHEAD = 2 * sizeof(SortEntry) + 16;
+static const size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+/**
+ * @brief Numeric ZIP key of a record; non-ZIP rows sort last.
+ */
+static uint32_t sortKey(const std::string& record) {
+    std::string zip;
+    if (!IndexManager::recordKey(record, zip) || zip.size() > 9) return UINT32_MAX;
+    return static_cast<uint32_t>(std::stoul(zip));
+}
+
+/**
+ * @brief Sequential reader over one run file with its own large stream buffer.
+ */
+struct RunReader {
+    std::vector<char> streamBuffer;  // declared before in so it outlives the stream
+    std::ifstream in;
+    std::string record;
+    uint32_t key = 0;
+    bool done = false;
+
+    bool open(const std::string& runFileName, size_t bufferBytes) {
+        streamBuffer.resize(bufferBytes);
+        in.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+        in.open(runFileName, std::ios::binary);
+        if (!in.is_open()) return false;
+        advance();
+        return true;
+    }
+
+    void advance() {
+        uint32_t recordLength = 0;
+        if (!in.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))) {
+            done = true;
+            return;
+        }
+        record.resize(recordLength);
+        if (!in.read(&record[0], recordLength)) {
+            done = true;
+            return;
+        }
+        key = sortKey(record);
+    }
+};
+
+/**
+ * @class LoserTree
+ * @brief Tournament tree for k-way merging: picking the next record costs
+ *        log2(k) comparisons along one leaf-to-root path.
+ *
+ * tree[0] is the overall winner; tree[1..k-1] hold the loser of each match.
+ */
+class LoserTree {
+public:
+    explicit LoserTree(std::vector<std::unique_ptr<RunReader>>& readers)
+        : runs(readers), k(readers.size()), tree(readers.size(), readers.size()) {
+        // Every node starts as the "minus infinity" sentinel k, which is pushed
+        // out as each real leaf is played in
+        for (size_t i = k; i-- > 0; ) adjust(i);
+    }
+
+    bool empty() const { return k == 0 || runs[tree[0]]->done; }
+    RunReader& top() { return *runs[tree[0]]; }
+
+    void pop() {
+        size_t winner = tree[0];
+        runs[winner]->advance();
+        adjust(winner);
+    }
+
+private:
+    std::vector<std::unique_ptr<RunReader>>& runs;
+    size_t k;
+    std::vector<size_t> tree;
+
+    // True if run a's current record should come out before run b's
+    bool beats(size_t a, size_t b) const {
+        if (a == k) return true;
+        if (b == k) return false;
+        if (runs[a]->done) return false;
+        if (runs[b]->done) return true;
+        if (runs[a]->key != runs[b]->key) return runs[a]->key < runs[b]->key;
+        return a < b; // earlier run first keeps the sort stable
+    }
+
+    void adjust(size_t leaf) {
+        size_t winner = leaf;
+        for (size_t t = (leaf + k) / 2; t > 0; t /= 2) {
+            if (beats(tree[t], winner)) std::swap(winner, tree[t]);
+        }
+        tree[0] = winner;
+    }
+};
+
+/**
+ * @brief Merges sorted run files, handing each record to @p sink in key order.
+ */
+static bool mergeRuns(const std::vector<std::string>& runFileNames, size_t bufferBytes,
+                      const std::function<void(const std::string&)>& sink) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    for (const auto& name : runFileNames) {
+        readers.emplace_back(new RunReader());
+        if (!readers.back()->open(name, bufferBytes)) {
+            std::cerr << "Error: Cannot open run file " << name << ".\n";
+            return false;
+        }
+    }
+
+    LoserTree tree(readers);
+    while (!tree.empty()) {
+        sink(tree.top().record);
+        tree.pop();
+    }
+    return true;
+}
+
+static bool writeRun(SortChunk& chunk, const std::string& runFileName, size_t bufferBytes) {
+    std::stable_sort(chunk.begin(), chunk.end(),
+        [](const SortEntry& a, const SortEntry& b) { return a.first < b.first; });
+
+    std::vector<char> streamBuffer(bufferBytes);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+    out.open(runFileName, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot open run file " << runFileName << " for writing.\n";
+        return false;
+    }
+
+    for (const auto& entry : chunk) {
+        uint32_t recordLength = static_cast<uint32_t>(entry.second.size());
+        out.write(reinterpret_cast<const char*>(&recordLength), sizeof(recordLength));
+        out.write(entry.second.data(), recordLength);
+    }
+    out.close();
+    return static_cast<bool>(out);
+}
+
+static void removeRuns(const std::vector<std::string>& runFileNames) {
+    for (const auto& name : runFileNames) std::remove(name.c_str());
+}
+
+bool externalSortToDataFile(const std::string& inputCSVFileName, const std::string& dataFileName,
+                            const std::string& indexFileName, size_t memoryBudget) {
+    std::ifstream input(inputCSVFileName);
+    if (!input.is_open()) {
+        std::cerr << "Error: Cannot open " << inputCSVFileName << " for sorting.\n";
+        return false;
+    }
+
+    // Phase 1 holds one chunk plus one run buffer per worker at a time, and a merge
+    // holds one buffer per input run plus one for its output; size all of them so
+    // either phase stays inside the budget. Fewer workers rather than tiny chunks.
+    const size_t budget = std::max(memoryBudget, MIN_SORT_MEMORY);
+    const size_t bufferBytes = std::min<size_t>(std::max<size_t>(budget / 16, 64 * 1024), 4 * 1024 * 1024);
+    const size_t maxFanIn = std::max<size_t>(2, budget / bufferBytes - 1);
+    const unsigned workers = static_cast<unsigned>(std::min<size_t>(
+        std::max(1u, std::thread::hardware_concurrency()),
+        std::max<size_t>(1, budget / (MIN_CHUNK_BYTES + bufferBytes))));
+    const size_t chunkBudget = budget / workers - bufferBytes;
+
+    // --- Phase 1: sorted runs, `workers` chunks at a time ---
+    std::vector<std::string> runs;
+    std::string line;
+    std::getline(input, line); // skip the CSV header row
+    bool more = true;
+
+    while (more) {
+        std::vector<SortChunk> batch;
+        for (unsigned w = 0; w < workers && more; ++w) {
+            batch.emplace_back();
+            size_t chunkBytes = 0;
+            while (chunkBytes < chunkBudget) {
+                if (!std::getline(input, line)) {
+                    more = false;
+                    break;
+                }
+                if (line.empty()) continue;
+                chunkBytes += line.size() + ENTRY_OVERHEAD;
+                batch.back().emplace_back(sortKey(line), line);
+            }
+            if (batch.back().empty()) batch.pop_back();
+        }
+
+        size_t firstRun = runs.size();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            runs.push_back(dataFileName + ".run" + std::to_string(firstRun + i));
+        }
+
+        std::vector<char> ok(batch.size(), 0);
+        parallelFor(batch.size(), [&](size_t i) {
+            ok[i] = writeRun(batch[i], runs[firstRun + i], bufferBytes);
+        }, workers);
+        if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+            removeRuns(runs);
+            return false;
+        }
+    }
+    input.close();
+
+    // --- Phase 2a: intermediate merge passes until one pass can take every run ---
+    size_t nextRun = runs.size();
+    while (runs.size() > maxFanIn) {
+        std::vector<std::string> merged;
+        for (size_t first = 0; first < runs.size(); first += maxFanIn) {
+            std::vector<std::string> group(runs.begin() + first,
+                                           runs.begin() + std::min(first + maxFanIn, runs.size()));
+            std::string mergedName = dataFileName + ".run" + std::to_string(nextRun++);
+
+            std::vector<char> streamBuffer(bufferBytes);
+            std::ofstream out;
+            out.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+            out.open(mergedName, std::ios::binary);
+
+            bool ok = out.is_open() && mergeRuns(group, bufferBytes, [&](const std::string& record) {
+                uint32_t recordLength = static_cast<uint32_t>(record.size());
+                out.write(reinterpret_cast<const char*>(&recordLength), sizeof(recordLength));
+                out.write(record.data(), recordLength);
+            });
+            out.close();
+            removeRuns(group);
+            if (!ok || !out) {
+                std::cerr << "Error: merge pass failed writing " << mergedName << ".\n";
+                removeRuns(merged);
+                removeRuns(std::vector<std::string>(runs.begin() + std::min(first + maxFanIn, runs.size()), runs.end()));
+                std::remove(mergedName.c_str());
+                return false;
+            }
+            merged.push_back(mergedName);
+        }
+        runs.swap(merged);
+    }
+
+    // --- Phase 2b: final merge straight into the data file, indexing as we go ---
+    DataFileWriter writer;
+    if (!writer.open(dataFileName, indexFileName, bufferBytes)) {
+        removeRuns(runs);
+        return false;
+    }
+    bool ok = mergeRuns(runs, bufferBytes, [&](const std::string& record) {
+        writer.append(record);
+    });
+    removeRuns(runs);
+
+    return writer.close() && ok;
+}
@@ -0,0 +1,43 @@
+#include "FileFingerprint.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+static const size_t SAMPLE_BLOCK_SIZE = 4096;
+static const size_t SAMPLE_BLOCKS = 16;
+
+/**
+ * @brief Hashes the first block (the header) and up to SAMPLE_BLOCKS blocks
+ *        spread evenly over the rest of the file, including the last one.
+ */
+bool sampledFileHash(const std::string& fileName, uint64_t& size, uint64_t& sampleHash) {
+    std::error_code error;
+    size = std::filesystem::file_size(fileName, error);
+    if (error) return false;
+
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    // Small files are hashed whole; larger ones by evenly spaced blocks plus the tail
+    std::vector<uint64_t> offsets;
+    if (size <= (SAMPLE_BLOCKS + 1) * SAMPLE_BLOCK_SIZE) {
+        for (uint64_t offset = 0; offset < size; offset += SAMPLE_BLOCK_SIZE) offsets.push_back(offset);
+    } else {
+        uint64_t stride = size / SAMPLE_BLOCKS;
+        for (size_t i = 0; i < SAMPLE_BLOCKS; ++i) offsets.push_back(i * stride);
+        offsets.push_back(size - SAMPLE_BLOCK_SIZE);
+    }
+
+    uint64_t hash = FNV1A_OFFSET_BASIS;
+    std::vector<char> block(SAMPLE_BLOCK_SIZE);
+    for (uint64_t offset : offsets) {
+        in.seekg(offset, std::ios::beg);
+        in.read(block.data(), block.size());
+        hash = fnv1a(block.data(), static_cast<size_t>(in.gcount()), hash);
+        in.clear(); // a short read at the tail sets eof
+    }
+
+    sampleHash = hash;
+    return true;
+}
@@ -0,0 +1,22 @@
+#include "FileReplace.h"
+
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+bool replaceFile(const std::string& tempName, const std::string& fileName) {
+#ifdef _WIN32
+    // Plain rename() refuses to overwrite on Windows; MoveFileEx replaces in one step
+    bool replaced = MoveFileExA(tempName.c_str(), fileName.c_str(),
+                                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool replaced = std::rename(tempName.c_str(), fileName.c_str()) == 0;
+#endif
+    if (!replaced) {
+        std::cerr << "Error: Cannot replace " << fileName << " with " << tempName << ".\n";
+    }
+    return replaced;
+}
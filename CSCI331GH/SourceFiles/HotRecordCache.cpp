@@ -0,0 +1,148 @@
+#include "HotRecordCache.h"
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+HotRecordCache::HotRecordCache(size_t capacity, size_t shardCount) : enabled(capacity > 0) {
+    shardCount = std::max<size_t>(1, std::min(shardCount, std::max<size_t>(capacity, 1)));
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.emplace_back(new Shard());
+        // Spread the capacity, giving the remainder to the first shards; entries
+        // grow on demand so a generous capacity costs nothing until it's used
+        shards.back()->capacity = capacity / shardCount + (i < capacity % shardCount ? 1 : 0);
+    }
+}
+
+HotRecordCache::Shard& HotRecordCache::shardFor(const std::string& zip) {
+    return *shards[std::hash<std::string>()(zip) % shards.size()];
+}
+
+/**
+ * @brief Formats a record exactly as the lookup output does with cout defaults.
+ */
+std::string HotRecordCache::render(const ZipCodeRecordBuffer& record) {
+    std::ostringstream out;
+    out << "ZIP Code: " << record.getZipCode() << "\n"
+        << "Place Name: " << record.getPlaceName() << "\n"
+        << "State: " << record.getState() << "\n"
+        << "County: " << record.getCounty() << "\n"
+        << "Latitude: " << record.getLatitude() << "\n"
+        << "Longitude: " << record.getLongitude() << "\n";
+    return out.str();
+}
+
+bool HotRecordCache::lookup(const std::string& zip, std::string& rendered) {
+    if (!enabled) {
+        ++misses;
+        return false;
+    }
+    Shard& shard = shardFor(zip);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.slotOf.find(zip);
+    if (it == shard.slotOf.end()) {
+        ++misses;
+        return false;
+    }
+    Entry& entry = shard.entries[it->second];
+    entry.referenced = true;
+    rendered = entry.rendered;
+    ++hits;
+    return true;
+}
+
+bool HotRecordCache::lookupRecord(const std::string& zip, ZipCodeRecordBuffer& record) {
+    if (!enabled) {
+        ++misses;
+        return false;
+    }
+    Shard& shard = shardFor(zip);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.slotOf.find(zip);
+    if (it == shard.slotOf.end()) {
+        ++misses;
+        return false;
+    }
+    Entry& entry = shard.entries[it->second];
+    entry.referenced = true;
+    record = entry.record;
+    ++hits;
+    return true;
+}
+
+void HotRecordCache::insert(const std::string& zip, const ZipCodeRecordBuffer& record) {
+    if (!enabled) return;
+    std::string rendered = render(record); // format outside the lock
+
+    Shard& shard = shardFor(zip);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.slotOf.find(zip);
+    if (it != shard.slotOf.end()) {
+        Entry& entry = shard.entries[it->second];
+        entry.record = record;
+        entry.rendered = std::move(rendered);
+        return;
+    }
+
+    size_t slot;
+    if (shard.entries.size() < shard.capacity) {
+        slot = shard.entries.size();
+        shard.entries.emplace_back();
+    } else {
+        // CLOCK: clear reference bits until an unreferenced victim comes round
+        while (shard.entries[shard.hand].referenced) {
+            shard.entries[shard.hand].referenced = false;
+            shard.hand = (shard.hand + 1) % shard.entries.size();
+        }
+        slot = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.entries.size();
+        shard.slotOf.erase(shard.entries[slot].zip);
+        ++evictions;
+    }
+
+    Entry& entry = shard.entries[slot];
+    entry.zip = zip;
+    entry.record = record;
+    entry.rendered = std::move(rendered);
+    entry.referenced = false; // must be hit once before it earns a second chance
+    shard.slotOf[zip] = slot;
+}
+
+void HotRecordCache::invalidate(const std::string& zip) {
+    Shard& shard = shardFor(zip);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.slotOf.find(zip);
+    if (it == shard.slotOf.end()) return;
+
+    // Move the last entry into the hole so entries stays dense
+    size_t slot = it->second;
+    size_t last = shard.entries.size() - 1;
+    shard.slotOf.erase(it);
+    if (slot != last) {
+        shard.entries[slot] = std::move(shard.entries[last]);
+        shard.slotOf[shard.entries[slot].zip] = slot;
+    }
+    shard.entries.pop_back();
+    if (shard.hand >= shard.entries.size()) shard.hand = 0;
+}
+
+void HotRecordCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->slotOf.clear();
+        shard->entries.clear();
+        shard->hand = 0;
+    }
+}
+
+HotRecordCache::Stats HotRecordCache::stats() const {
+    Stats s;
+    s.hits = hits.load();
+    s.misses = misses.load();
+    s.evictions = evictions.load();
+    return s;
+}
@@ -1,12 +1,20 @@
 #include "IndexManager.h"
 #include "ZipCodeRecordBuffer.h"
 #include "HeaderBuffer.h"
+#include "Crc32c.h"
+#include "FileFingerprint.h"
+#include "FileReplace.h"
 
 #include <sstream>
 #include <algorithm>
+#include <cstdio>
 #include <cctype>
 #include <iostream>
 #include <fstream>
+#include <initializer_list>
+#include <iterator>
+
+static const char DATA_STAMP_MAGIC[4] = {'D', 'A', 'T', 'A'};
 
 /**
  * @brief Builds the index by scanning through the binary data file.
@@ -14,11 +22,11 @@
  * Each record starts with a 4-byte length field followed by CSV data.
  * We read each record, extract the ZIP code, and record its offset.
  */
-void IndexManager::buildIndex(const std::string& dataFileName) {
+bool IndexManager::buildIndex(const std::string& dataFileName) {
     std::ifstream dataFile(dataFileName, std::ios::binary);
     if (!dataFile.is_open()) {
         std::cerr << "Error: Cannot open " << dataFileName << " for indexing.\n";
-        return;
+        return false;
     }
 
     indexMap.clear();
@@ -26,23 +34,28 @@ void IndexManager::buildIndex(const std::string& dataFileName) {
     HeaderRecordBuffer header;
     if (!header.readHeader(dataFile)) {
         std::cerr << "Error reading header in IndexManager.\n";
-        return;
+        return false;
     }
 
     uint64_t offset = dataFile.tellg(); // Get initial offset after header
+    dataFile.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(dataFile.tellg());
+    dataFile.seekg(offset, std::ios::beg);
     uint32_t recordLength = 0;
 
     while (dataFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))) {
-        
+        // A torn or truncated file can leave a garbage length; don't allocate it
+        if (recordLength > fileSize - offset - sizeof(recordLength)) {
+            std::cerr << "Error: corrupt record length " << recordLength << " at offset "
+                      << offset << " in " << dataFileName << ".\n";
+            return false;
+        }
+
         std::string record(recordLength, '\0');
         dataFile.read(&record[0], recordLength);
 
-        std::istringstream ss(record);
         std::string zip;
-        std::getline(ss, zip, ',');
-
-        if (std::all_of(zip.begin(), zip.end(),
-            [](char c){ return std::isdigit(static_cast<unsigned char>(c)); })) {
+        if (recordKey(record, zip)) {
             indexMap[zip] = offset; // <-- Store the offset captured BEFORE the read
         }
 
@@ -51,6 +64,18 @@ void IndexManager::buildIndex(const std::string& dataFileName) {
     }
 
     dataFile.close();
+    return true;
+}
+
+/**
+ * @brief Returns the leading comma-separated field if it is all digits.
+ */
+bool IndexManager::recordKey(const std::string& record, std::string& zip) {
+    std::istringstream ss(record);
+    std::getline(ss, zip, ',');
+
+    return !zip.empty() && std::all_of(zip.begin(), zip.end(),
+        [](char c){ return std::isdigit(static_cast<unsigned char>(c)); });
 }
 
 /**
@@ -60,57 +85,141 @@ void IndexManager::buildIndex(const std::string& dataFileName) {
  * [entryCount:uint32_t]
  * For each entry:
  *   [keyLen:uint16_t][ZIP chars][offset:uint64_t]
+ * Optional data file stamp:
+ *   [magic "DATA":char[4]][dataFileSize:uint64_t][dataFileHash:uint64_t]
+ * [crc32c of everything above:uint32_t]
  */
-void IndexManager::writeIndex(const std::string& indexFileName) const {
-    std::ofstream out(indexFileName, std::ios::binary);
+bool IndexManager::writeIndex(const std::string& indexFileName, const std::string& dataFileName) {
+    hasDataFileStamp = !dataFileName.empty() && sampledFileHash(dataFileName, dataFileSize, dataFileHash);
+
+    // Written to a temp file and renamed into place, so a crash never leaves a torn index
+    const std::string tempName = indexFileName + ".tmp";
+    std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
     if (!out) {
-        std::cerr << "Error: Cannot open " << indexFileName << " for writing.\n";
-        return;
+        std::cerr << "Error: Cannot open " << tempName << " for writing.\n";
+        return false;
     }
 
+    // Build the file in memory so the checksum trailer can be computed in one go
+    std::ostringstream body(std::ios::binary);
     uint32_t count = static_cast<uint32_t>(indexMap.size());
-    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    body.write(reinterpret_cast<const char*>(&count), sizeof(count));
 
     for (const auto& entry : indexMap) {
         uint16_t keyLen = static_cast<uint16_t>(entry.first.size());
-        out.write(reinterpret_cast<const char*>(&keyLen), sizeof(keyLen));
-        out.write(entry.first.c_str(), keyLen);
-        out.write(reinterpret_cast<const char*>(&entry.second), sizeof(entry.second));
+        body.write(reinterpret_cast<const char*>(&keyLen), sizeof(keyLen));
+        body.write(entry.first.c_str(), keyLen);
+        body.write(reinterpret_cast<const char*>(&entry.second), sizeof(entry.second));
     }
 
+    if (hasDataFileStamp) {
+        body.write(DATA_STAMP_MAGIC, sizeof(DATA_STAMP_MAGIC));
+        body.write(reinterpret_cast<const char*>(&dataFileSize), sizeof(dataFileSize));
+        body.write(reinterpret_cast<const char*>(&dataFileHash), sizeof(dataFileHash));
+    }
+
+    const std::string bytes = body.str();
+    uint32_t checksum = crc32c(bytes.data(), bytes.size());
+    out.write(bytes.data(), bytes.size());
+    out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+
     out.close();
+    if (!out) {
+        std::cerr << "Error writing " << tempName << ".\n";
+        std::remove(tempName.c_str());
+        return false;
+    }
+    if (!replaceFile(tempName, indexFileName)) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
 }
 
 /**
  * @brief Reads an index file from disk back into memory.
+ *
+ * The checksum trailer is verified when present; index files written before it
+ * existed (no trailer) are still accepted.
  */
-void IndexManager::readIndex(const std::string& indexFileName) {
+bool IndexManager::readIndex(const std::string& indexFileName) {
     std::ifstream in(indexFileName, std::ios::binary);
     if (!in) {
         std::cerr << "Error: Cannot open " << indexFileName << " for reading.\n";
-        return;
+        return false;
     }
 
     indexMap.clear();
+    hasDataFileStamp = false;
+
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::istringstream body(bytes);
 
     uint32_t count = 0;
-    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!body.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        std::cerr << "Error: " << indexFileName << " is empty.\n";
+        return false;
+    }
 
     for (uint32_t i = 0; i < count; ++i) {
         uint16_t keyLen = 0;
-        in.read(reinterpret_cast<char*>(&keyLen), sizeof(keyLen));
+        body.read(reinterpret_cast<char*>(&keyLen), sizeof(keyLen));
 
         std::string zip(keyLen, '\0');
-        in.read(&zip[0], keyLen);
+        body.read(&zip[0], keyLen);
 
         uint64_t offset = 0;
-        in.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+        body.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+
+        if (!body) {
+            std::cerr << "Error: " << indexFileName << " is truncated at entry " << i << ".\n";
+            indexMap.clear();
+            return false;
+        }
 
         indexMap[zip] = offset;
     }
 
-    in.close();
+    // Optional data file stamp, only written together with a checksum trailer
+    const size_t stampSize = sizeof(DATA_STAMP_MAGIC) + sizeof(dataFileSize) + sizeof(dataFileHash);
+    size_t entriesEnd = static_cast<size_t>(body.tellg());
+    if (bytes.size() == entriesEnd + stampSize + sizeof(uint32_t)
+        && bytes.compare(entriesEnd, sizeof(DATA_STAMP_MAGIC), DATA_STAMP_MAGIC, sizeof(DATA_STAMP_MAGIC)) == 0) {
+        body.seekg(static_cast<std::streamoff>(entriesEnd + sizeof(DATA_STAMP_MAGIC)));
+        body.read(reinterpret_cast<char*>(&dataFileSize), sizeof(dataFileSize));
+        body.read(reinterpret_cast<char*>(&dataFileHash), sizeof(dataFileHash));
+        hasDataFileStamp = true;
+    }
+
+    size_t bodySize = static_cast<size_t>(body.tellg());
+    uint32_t checksum = 0;
+    if (bytes.size() == bodySize + sizeof(checksum)) {
+        std::copy(bytes.end() - sizeof(checksum), bytes.end(), reinterpret_cast<char*>(&checksum));
+        if (crc32c(bytes.data(), bodySize) != checksum) {
+            std::cerr << "Error: " << indexFileName << " failed its checksum.\n";
+            indexMap.clear();
+            hasDataFileStamp = false;
+            return false;
+        }
+    } else if (bytes.size() != bodySize) {
+        std::cerr << "Error: " << indexFileName << " has " << (bytes.size() - bodySize)
+                  << " unexpected trailing bytes.\n";
+        indexMap.clear();
+        return false;
+    }
+
     std::cout << "Loaded index with " << count << " entries.\n";
+    return true;
+}
+
+/**
+ * @brief Compares the stamp from readIndex()/writeIndex() with the data file on disk.
+ */
+bool IndexManager::belongsTo(const std::string& dataFileName) const {
+    uint64_t size = 0, hash = 0;
+    return hasDataFileStamp && sampledFileHash(dataFileName, size, hash)
+        && size == dataFileSize && hash == dataFileHash;
 }
 
 /**
@@ -120,3 +229,17 @@ uint64_t IndexManager::findOffset(const std::string& zip) const {
     auto it = indexMap.find(zip);
     return (it != indexMap.end()) ? it->second : UINT64_MAX;
 }
+
+bool IndexManager::findKey(const std::string& zip, std::string& storedKey) const {
+    size_t first = zip.find_first_not_of('0');
+    std::string unpadded = first == std::string::npos ? std::string("0") : zip.substr(first);
+    std::string padded = unpadded.size() < 5 ? std::string(5 - unpadded.size(), '0') + unpadded : unpadded;
+
+    for (const std::string& key : {zip, unpadded, padded}) {
+        if (indexMap.count(key)) {
+            storedKey = key;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,145 @@
+#include "ResultCache.h"
+#include "FileFingerprint.h"
+#include "FileReplace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static const char CACHE_MAGIC[8] = {'Z', 'I', 'P', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t CACHE_VERSION = 2; // 2: length-prefixed report fields
+
+static void writeString(std::ostream& out, const std::string& s) {
+    uint32_t length = static_cast<uint32_t>(s.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(s.data(), length);
+}
+
+static bool readString(std::istream& in, uint64_t limit, std::string& s) {
+    uint32_t length = 0;
+    if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > limit) return false;
+    s.assign(length, '\0');
+    return length == 0 || static_cast<bool>(in.read(&s[0], length));
+}
+
+ResultCache::ResultCache(const std::string& sourceFileName, const std::string& cacheFileName)
+    : sourceFileName(sourceFileName), cacheFileName(cacheFileName) {}
+
+void ResultCache::registerAggregate(const std::string& name, Compute compute) {
+    aggregates[name] = compute;
+}
+
+/**
+ * @brief The sampled-block hash from FileFingerprint plus the modification time.
+ */
+bool ResultCache::fingerprintOf(const std::string& fileName, Fingerprint& fingerprint) {
+    if (!sampledFileHash(fileName, fingerprint.size, fingerprint.sampleHash)) return false;
+    std::error_code error;
+    fingerprint.modified = std::filesystem::last_write_time(fileName, error).time_since_epoch().count();
+    return !error;
+}
+
+/**
+ * @brief Loads cached payloads if the cache was written for the current source.
+ *
+ * Cache file format:
+ *   [magic:char[8]][version:uint32_t][size:uint64_t][modified:int64_t][sampleHash:uint64_t]
+ *   [entryCount:uint32_t] then per entry [nameLen:uint32_t][name][payloadLen:uint32_t][payload]
+ */
+void ResultCache::load() {
+    loaded = true;
+    results.clear();
+    if (!fingerprintOf(sourceFileName, sourceFingerprint)) return;
+
+    std::ifstream in(cacheFileName, std::ios::binary);
+    if (!in.is_open()) return;
+    std::error_code error;
+    uint64_t cacheSize = std::filesystem::file_size(cacheFileName, error); // bounds each string
+    if (error) return;
+
+    char magic[sizeof(CACHE_MAGIC)] = {};
+    uint32_t version = 0;
+    Fingerprint cached;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&cached.size), sizeof(cached.size));
+    in.read(reinterpret_cast<char*>(&cached.modified), sizeof(cached.modified));
+    in.read(reinterpret_cast<char*>(&cached.sampleHash), sizeof(cached.sampleHash));
+    if (!in || !std::equal(magic, magic + sizeof(magic), CACHE_MAGIC) || version != CACHE_VERSION
+        || !(cached == sourceFingerprint)) {
+        return; // stale or foreign cache: recompute on demand
+    }
+
+    uint32_t count = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    for (uint32_t i = 0; i < count && in; ++i) {
+        std::string name, payload;
+        if (!readString(in, cacheSize, name) || !readString(in, cacheSize, payload)) {
+            results.clear(); // truncated cache: trust none of it
+            return;
+        }
+        results[name] = payload;
+    }
+}
+
+/**
+ * @brief Writes every payload to a temp file and renames it over the cache, so an
+ *        interrupted save leaves the previous cache rather than a torn one.
+ */
+void ResultCache::save() const {
+    const std::string tempName = cacheFileName + ".tmp";
+    std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Warning: Cannot write cache file " << tempName << ".\n";
+        return;
+    }
+
+    out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+    out.write(reinterpret_cast<const char*>(&sourceFingerprint.size), sizeof(sourceFingerprint.size));
+    out.write(reinterpret_cast<const char*>(&sourceFingerprint.modified), sizeof(sourceFingerprint.modified));
+    out.write(reinterpret_cast<const char*>(&sourceFingerprint.sampleHash), sizeof(sourceFingerprint.sampleHash));
+
+    uint32_t count = static_cast<uint32_t>(results.size());
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& entry : results) {
+        writeString(out, entry.first);
+        writeString(out, entry.second);
+    }
+
+    out.close();
+    if (!out) {
+        std::cerr << "Warning: Cannot write cache file " << tempName << ".\n";
+        std::remove(tempName.c_str());
+        return;
+    }
+    if (!replaceFile(tempName, cacheFileName)) std::remove(tempName.c_str());
+}
+
+void ResultCache::discard(const std::string& name) {
+    if (!loaded) load();
+    if (results.erase(name) > 0) save();
+}
+
+bool ResultCache::get(const std::string& name, std::string& payload) {
+    if (!loaded) load();
+
+    auto cached = results.find(name);
+    if (cached != results.end()) {
+        payload = cached->second;
+        return true;
+    }
+
+    auto aggregate = aggregates.find(name);
+    if (aggregate == aggregates.end()) {
+        std::cerr << "Error: no aggregate named " << name << " is registered.\n";
+        return false;
+    }
+    if (!aggregate->second(payload)) return false;
+
+    results[name] = payload;
+    save();
+    return true;
+}
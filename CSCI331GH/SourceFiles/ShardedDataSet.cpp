@@ -0,0 +1,370 @@
+#include "ShardedDataSet.h"
+#include "FileReplace.h"
+#include "DataFileWriter.h"
+#include "HeaderBuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const char* MANIFEST_TAG = "ZIP_SHARD_MANIFEST";
+
+std::string ShardedDataSet::paddedZip(const std::string& zip) {
+    if (zip.size() >= 5) return zip;
+    return std::string(5 - zip.size(), '0') + zip;
+}
+
+/**
+ * @brief Drops leading zeros ("00501" → "501"), the form the source CSVs use as keys.
+ */
+static std::string unpaddedZip(const std::string& zip) {
+    size_t first = zip.find_first_not_of('0');
+    return first == std::string::npos ? "0" : zip.substr(first);
+}
+
+/**
+ * @brief Numeric value of an all-digit key, or false if it has more than 9
+ *        significant digits (no such key can fall inside a uint32_t ZIP range).
+ */
+static bool zipValue(const std::string& key, uint32_t& value) {
+    std::string digits = unpaddedZip(key);
+    if (key.empty() || digits.size() > 9) return false;
+
+    value = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<uint32_t>(c - '0');
+    }
+    return true;
+}
+
+static bool isDigits(const std::string& text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+/**
+ * @brief The shard a ZIP routes to; build, rebuildShard and findRecord must agree.
+ */
+static std::string shardPrefix(const std::string& zip, int prefixDigits) {
+    return ShardedDataSet::paddedZip(unpaddedZip(zip)).substr(0, prefixDigits);
+}
+
+/**
+ * @brief Reads the CSV once, buckets lines by ZIP prefix, then writes each bucket
+ *        as its own data file + index on the worker pool.
+ *
+ * Manifest format (text):
+ *   ZIP_SHARD_MANIFEST
+ *   prefixDigits <d>
+ *   shards <n>
+ *   <prefix> <dataFile> <indexFile> <recordCount>   (one line per shard)
+ */
+bool ShardedDataSet::build(const std::string& inputCSVFileName, const std::string& manifestFileName,
+                           int prefixDigits, const std::vector<std::string>& shardDirectories) {
+    if (prefixDigits < 1 || prefixDigits > 4) {
+        std::cerr << "Error: shard prefix must be 1 to 4 digits.\n";
+        return false;
+    }
+
+    // The manifest is whitespace-separated, so paths can't contain spaces
+    std::vector<std::string> directories;
+    for (std::string directory : shardDirectories) {
+        if (directory.empty() || directory.find_first_of(" \t\r\n") != std::string::npos) {
+            std::cerr << "Error: shard directory '" << directory << "' is empty or contains whitespace.\n";
+            return false;
+        }
+        if (directory.back() != '/' && directory.back() != '\\') directory += '/';
+        directories.push_back(directory);
+    }
+    if (directories.empty()) {
+        // Shard files default to the manifest's directory
+        size_t slash = manifestFileName.find_last_of("/\\");
+        directories.push_back(slash == std::string::npos ? "" : manifestFileName.substr(0, slash + 1));
+    }
+
+    std::ifstream input(inputCSVFileName);
+    if (!input.is_open()) {
+        std::cerr << "Error: Cannot open " << inputCSVFileName << " for sharding.\n";
+        return false;
+    }
+
+    std::map<std::string, std::vector<std::string>> buckets;
+    std::string line;
+    std::getline(input, line); // skip the CSV header row
+    while (std::getline(input, line)) {
+        std::string zip;
+        if (line.empty() || !IndexManager::recordKey(line, zip)) continue;
+        buckets[shardPrefix(zip, prefixDigits)].push_back(line);
+    }
+    input.close();
+
+    std::vector<ShardInfo> shards;
+    std::vector<const std::vector<std::string>*> shardRecords;
+    for (const auto& bucket : buckets) {
+        const std::string& directory = directories[shards.size() % directories.size()];
+        ShardInfo info;
+        info.prefix = bucket.first;
+        info.dataFileName = directory + "shard_" + bucket.first + ".dat";
+        info.indexFileName = directory + "shard_" + bucket.first + ".idx";
+        shards.push_back(info);
+        shardRecords.push_back(&bucket.second);
+    }
+
+    std::vector<char> ok(shards.size(), 0);
+    parallelFor(shards.size(), [&](size_t i) {
+        DataFileWriter writer;
+        if (!writer.open(shards[i].dataFileName, shards[i].indexFileName)) return;
+        for (const auto& record : *shardRecords[i]) writer.append(record);
+        shards[i].recordCount = writer.recordCount();
+        ok[i] = writer.close();
+    });
+
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        std::cerr << "Error: one or more shards failed to build.\n";
+        return false;
+    }
+
+    if (!writeManifest(manifestFileName, prefixDigits, shards)) return false;
+    std::cout << "Built " << shards.size() << " shards from " << inputCSVFileName << ".\n";
+    return true;
+}
+
+/**
+ * @brief Writes the manifest to a temp file and renames it into place, so a crash
+ *        leaves the old manifest or the new one.
+ */
+bool ShardedDataSet::writeManifest(const std::string& manifestFileName, int prefixDigits,
+                                   const std::vector<ShardInfo>& shards) {
+    std::string tempName = manifestFileName + ".tmp";
+    std::ofstream manifest(tempName, std::ios::trunc);
+    manifest << MANIFEST_TAG << "\n"
+             << "prefixDigits " << prefixDigits << "\n"
+             << "shards " << shards.size() << "\n";
+    for (const auto& shard : shards) {
+        manifest << shard.prefix << " " << shard.dataFileName << " "
+                 << shard.indexFileName << " " << shard.recordCount << "\n";
+    }
+    manifest.close();
+    if (!manifest) {
+        std::cerr << "Error: Cannot write " << tempName << ".\n";
+        std::remove(tempName.c_str());
+        return false;
+    }
+
+    if (!replaceFile(tempName, manifestFileName)) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ShardedDataSet::open(const std::string& manifestName) {
+    std::ifstream manifest(manifestName);
+    if (!manifest.is_open()) {
+        std::cerr << "Error: Cannot open " << manifestName << " for reading.\n";
+        return false;
+    }
+
+    std::string tag, label;
+    size_t count = 0;
+    manifest >> tag >> label >> prefixDigits >> label >> count;
+    if (!manifest || tag != MANIFEST_TAG || prefixDigits < 1 || prefixDigits > 4 || count > 10000) {
+        std::cerr << "Error: " << manifestName << " is not a shard manifest.\n";
+        return false;
+    }
+    manifestFileName = manifestName;
+
+    shards.assign(count, ShardInfo());
+    indexes.assign(count, IndexManager());
+    shardByPrefix.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        ShardInfo& shard = shards[i];
+        if (!(manifest >> shard.prefix >> shard.dataFileName >> shard.indexFileName >> shard.recordCount)) {
+            std::cerr << "Error: " << manifestName << " is truncated at shard " << i << ".\n";
+            return false;
+        }
+        if (!isDigits(shard.prefix) || shard.prefix.size() != static_cast<size_t>(prefixDigits)) {
+            std::cerr << "Error: " << manifestName << " has a bad shard prefix '" << shard.prefix << "'.\n";
+            return false;
+        }
+        if (!indexes[i].readIndex(shard.indexFileName)) return false;
+        if (!indexes[i].belongsTo(shard.dataFileName)) {
+            std::cerr << "Error: " << shard.indexFileName << " was not written for " << shard.dataFileName
+                      << "; rebuild shard " << shard.prefix << ".\n";
+            return false;
+        }
+        shardByPrefix[shard.prefix] = i;
+    }
+    return true;
+}
+
+/**
+ * @brief Rescans the CSV for one prefix and rewrites that shard's data file and index
+ *        under their manifest names; other shards' files are never opened.
+ *
+ * DataFileWriter renames the finished data file over the old one, so a crash
+ * leaves either the old shard or the new one. If it strikes before the new index
+ * is in place, open() refuses the mismatched pair until the shard is rebuilt.
+ */
+bool ShardedDataSet::rebuildShard(const std::string& prefix, const std::string& inputCSVFileName) {
+    auto found = shardByPrefix.find(prefix);
+    if (found == shardByPrefix.end()) {
+        std::cerr << "Error: no shard for prefix '" << prefix << "' in " << manifestFileName << ".\n";
+        return false;
+    }
+    ShardInfo& shard = shards[found->second];
+
+    std::ifstream input(inputCSVFileName);
+    if (!input.is_open()) {
+        std::cerr << "Error: Cannot open " << inputCSVFileName << " for sharding.\n";
+        return false;
+    }
+
+    DataFileWriter writer;
+    if (!writer.open(shard.dataFileName, shard.indexFileName)) return false;
+    std::string line;
+    std::getline(input, line); // skip the CSV header row
+    while (std::getline(input, line)) {
+        std::string zip;
+        if (line.empty() || !IndexManager::recordKey(line, zip)) continue;
+        if (shardPrefix(zip, prefixDigits) == prefix) writer.append(line);
+    }
+    shard.recordCount = writer.recordCount();
+    if (!writer.close()) return false;
+
+    IndexManager rebuilt;
+    if (!rebuilt.readIndex(shard.indexFileName)) return false;
+    indexes[found->second] = std::move(rebuilt);
+
+    std::cout << "Rebuilt shard " << prefix << " (" << shard.recordCount << " records) from "
+              << inputCSVFileName << ".\n";
+    return writeManifest(manifestFileName, prefixDigits, shards);
+}
+
+bool ShardedDataSet::readRecordAt(std::ifstream& in, uint64_t offset, std::string& record) {
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+
+    uint32_t recordLength = 0;
+    in.seekg(offset, std::ios::beg);
+    if (!in.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))) return false;
+    if (recordLength > fileSize - offset - sizeof(recordLength)) return false; // corrupt length
+
+    record.assign(recordLength, '\0');
+    return static_cast<bool>(in.read(&record[0], recordLength));
+}
+
+/**
+ * @brief Routes a point lookup to the one shard owning the ZIP's prefix.
+ */
+bool ShardedDataSet::findRecord(const std::string& zip, std::string& record) const {
+    if (!isDigits(zip)) return false;
+    auto shard = shardByPrefix.find(shardPrefix(zip, prefixDigits));
+    if (shard == shardByPrefix.end()) return false;
+
+    // Index keys are spelled as in the source CSV: unpadded, or padded in some exports
+    const IndexManager& index = indexes[shard->second];
+    std::string key;
+    if (!index.findKey(zip, key)) return false;
+    uint64_t offset = index.findOffset(key);
+
+    std::ifstream in(shards[shard->second].dataFileName, std::ios::binary);
+    return in.is_open() && readRecordAt(in, offset, record);
+}
+
+/**
+ * @brief Searches only the shards whose prefix range overlaps [lowZip, highZip].
+ *
+ * Shards own disjoint, ordered ZIP ranges, so sorting within each shard and
+ * concatenating in prefix order gives a fully ordered result.
+ */
+bool ShardedDataSet::rangeQuery(uint32_t lowZip, uint32_t highZip, std::vector<std::string>& results) const {
+    uint32_t shardSpan = 1;
+    for (int d = prefixDigits; d < 5; ++d) shardSpan *= 10;
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        uint32_t first = static_cast<uint32_t>(std::stoul(shards[i].prefix)) * shardSpan;
+        uint32_t last = first + shardSpan - 1;
+        if (first <= highZip && last >= lowZip) candidates.push_back(i);
+    }
+
+    std::vector<std::vector<std::pair<uint32_t, std::string>>> partials(candidates.size());
+    std::vector<char> ok(candidates.size(), 0);
+    parallelFor(candidates.size(), [&](size_t c) {
+        size_t i = candidates[c];
+        std::ifstream in(shards[i].dataFileName, std::ios::binary);
+        if (!in.is_open()) {
+            std::cerr << "Error: Cannot open shard " << shards[i].dataFileName << ".\n";
+            return;
+        }
+
+        for (const auto& entry : indexes[i].entries()) {
+            uint32_t zip = 0;
+            if (!zipValue(entry.first, zip) || zip < lowZip || zip > highZip) continue;
+
+            std::string record;
+            if (!readRecordAt(in, entry.second, record)) {
+                std::cerr << "Error: Cannot read ZIP code " << entry.first << " from shard "
+                          << shards[i].dataFileName << ".\n";
+                return;
+            }
+            partials[c].emplace_back(zip, record);
+        }
+        std::sort(partials[c].begin(), partials[c].end());
+        ok[c] = 1;
+    });
+
+    results.clear();
+    for (const auto& partial : partials) {
+        for (const auto& hit : partial) results.push_back(hit.second);
+    }
+    return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+/**
+ * @brief Sequentially parses every live record of one shard.
+ * @return False if the shard can't be read to the end (missing, truncated or a
+ *         corrupt record length); records before the damage have been visited.
+ */
+bool ShardedDataSet::scanShard(size_t shard, const std::function<void(const ZipCodeRecordBuffer&)>& visit) const {
+    const std::string& dataFileName = shards[shard].dataFileName;
+    std::ifstream in(dataFileName, std::ios::binary);
+    HeaderRecordBuffer header;
+    if (!in.is_open() || !header.readHeader(in)) {
+        std::cerr << "Error reading shard " << dataFileName << ".\n";
+        return false;
+    }
+
+    uint64_t offset = static_cast<uint64_t>(in.tellg());
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(offset, std::ios::beg);
+
+    while (offset < fileSize) {
+        // A torn or truncated shard can leave a garbage length; don't allocate it
+        uint32_t recordLength = 0;
+        if (fileSize - offset < sizeof(recordLength)
+            || !in.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))
+            || recordLength > fileSize - offset - sizeof(recordLength)) {
+            std::cerr << "Error: corrupt record length at offset " << offset << " in " << dataFileName << ".\n";
+            return false;
+        }
+
+        std::string record(recordLength, '\0');
+        if (!in.read(&record[0], recordLength)) {
+            std::cerr << "Error reading shard " << dataFileName << " at offset " << offset << ".\n";
+            return false;
+        }
+        offset += sizeof(recordLength) + recordLength;
+        if (!record.empty() && record[0] == '*') continue; // tombstone
+
+        ZipCodeRecordBuffer buffer;
+        std::istringstream ss(record);
+        if (buffer.ReadRecord(ss)) visit(buffer);
+    }
+    return true;
+}
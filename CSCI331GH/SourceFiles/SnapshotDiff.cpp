@@ -0,0 +1,439 @@
+#include "SnapshotDiff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include "AsyncRecordFetcher.h"
+#include "Crc32c.h"
+#include "FileFingerprint.h"
+#include "HeaderBuffer.h"
+#include "IndexManager.h"
+#include "ParallelFor.h"
+#include "ZipCodeDataFile.h"
+#include "ZipCodeRecordBuffer.h"
+
+static const char CHANGESET_MAGIC[8] = {'Z', 'I', 'P', 'D', 'E', 'L', 'T', 'A'};
+static const size_t HASH_CHUNK = 4096;  ///< Records hashed per parallelFor task
+
+namespace {
+
+/**
+ * @brief One record of a snapshot: its ZIP code, the raw text as stored, and
+ *        (after hashing) its normalized form and that form's hash.
+ */
+struct SnapshotRecord {
+    std::string zip;
+    std::string raw;
+    std::string normalized;
+    uint64_t hash = 0;
+    bool valid = false;
+};
+
+/**
+ * @brief All records of one side of a diff. keyOrdered means the records were
+ *        read through an index and are sorted by ZIP code.
+ */
+struct Snapshot {
+    std::vector<SnapshotRecord> records;
+    bool keyOrdered = false;
+};
+
+/**
+ * @brief ZIP codes without leading zeros, matching the index keys ("00501" -> "501").
+ */
+std::string normalizeZip(const std::string& zip) {
+    size_t first = zip.find_first_not_of('0');
+    return first == std::string::npos ? std::string("0") : zip.substr(first);
+}
+
+/**
+ * @brief Rebuilds a record as "zip,place,state,county,lat,lon" from its parsed
+ *        fields, so two snapshots agree whatever their source formatting.
+ */
+bool normalizeRecord(const std::string& raw, std::string& zip, std::string& normalized) {
+    ZipCodeRecordBuffer buffer;
+    std::istringstream ss(raw);
+    if (!buffer.ReadRecord(ss)) return false;
+
+    zip = normalizeZip(buffer.getZipCode());
+    std::ostringstream out;
+    out << std::setprecision(10) << zip << ',' << buffer.getPlaceName() << ',' << buffer.getState() << ','
+        << buffer.getCounty() << ',' << buffer.getLatitude() << ',' << buffer.getLongitude();
+    normalized = out.str();
+    return true;
+}
+
+/**
+ * @brief Normalizes and hashes every record, HASH_CHUNK records per task.
+ */
+void hashRecords(Snapshot& snapshot) {
+    std::vector<SnapshotRecord>& records = snapshot.records;
+    size_t chunks = (records.size() + HASH_CHUNK - 1) / HASH_CHUNK;
+    parallelFor(chunks, [&](size_t c) {
+        size_t end = std::min(records.size(), (c + 1) * HASH_CHUNK);
+        for (size_t i = c * HASH_CHUNK; i < end; ++i) {
+            SnapshotRecord& r = records[i];
+            std::string zip;
+            r.valid = normalizeRecord(r.raw, zip, r.normalized);
+            if (!r.valid) continue;
+            // Records read through an index keep the index key; it must agree
+            if (snapshot.keyOrdered && zip != r.zip) r.valid = false;
+            r.zip = zip;
+            r.hash = fnv1a(r.normalized);
+            std::string().swap(r.raw);
+        }
+    });
+}
+
+bool loadCsv(const std::string& fileName, Snapshot& snapshot) {
+    std::ifstream in(fileName);
+    if (!in.is_open()) {
+        std::cerr << "Error opening " << fileName << ".\n";
+        return false;
+    }
+    std::string line;
+    std::getline(in, line); // column headings
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        snapshot.records.emplace_back();
+        snapshot.records.back().raw = std::move(line);
+    }
+    snapshot.keyOrdered = false;
+    return true;
+}
+
+/**
+ * @brief The index kept next to a data file: "Data/old.dat" -> "Data/old.idx".
+ */
+std::string siblingIndexName(const std::string& fileName) {
+    size_t slash = fileName.find_last_of("/\\");
+    size_t dot = fileName.find_last_of('.');
+    bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    return (hasExtension ? fileName.substr(0, dot) : fileName) + ".idx";
+}
+
+/**
+ * @brief Loads the index of @p fileName from @p indexFileName, if that index was
+ *        written for this very file.
+ */
+bool loadOwnIndex(const std::string& fileName, const std::string& indexFileName,
+                  const HeaderRecordBuffer& header, IndexManager& index) {
+    std::ifstream probe(indexFileName, std::ios::binary);
+    if (!probe.is_open()) return false;
+    probe.close();
+
+    index = IndexManager();
+    return index.readIndex(indexFileName) && index.size() == header.recordCount && index.belongsTo(fileName);
+}
+
+/**
+ * @brief Reads a data file's live records in key order through its index.
+ *
+ * Every data file's header names the same index path by default, so a copy such
+ * as "old.dat" would share "Data/zip.idx" with the current file. The index next
+ * to the data file ("old.idx") is tried first, then the one in the header; either
+ * is used only if its data file stamp matches this file. Otherwise this fails
+ * (without complaint) and the caller scans instead.
+ */
+bool loadDataFileByIndex(const std::string& fileName, const HeaderRecordBuffer& header, Snapshot& snapshot) {
+    IndexManager index;
+    const std::string sibling = siblingIndexName(fileName);
+    if (!loadOwnIndex(fileName, sibling, header, index) &&
+        (header.indexFileName == sibling || !loadOwnIndex(fileName, header.indexFileName, header, index))) {
+        return false;
+    }
+
+    std::vector<uint64_t> offsets;
+    std::vector<SnapshotRecord> records(index.size());
+    size_t i = 0;
+    for (const auto& entry : index.entries()) {
+        records[i++].zip = entry.first;
+        offsets.push_back(entry.second);
+    }
+
+    AsyncRecordFetcher fetcher(fileName);
+    if (!fetcher.isOpen()) return false;
+    bool ok = fetcher.fetchBatch(offsets, [&](size_t k, const std::string& record) {
+        records[k].raw = record;
+    });
+    if (!ok) return false;
+
+    snapshot.records = std::move(records);
+    snapshot.keyOrdered = true;
+    return true;
+}
+
+/**
+ * @brief Reads every live record of a data file in file order.
+ */
+bool loadDataFileByScan(std::ifstream& in, const std::string& fileName, Snapshot& snapshot) {
+    uint64_t offset = static_cast<uint64_t>(in.tellg());
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+
+    uint32_t recordLength;
+    while (in.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))) {
+        if (recordLength > fileSize - offset - sizeof(recordLength)) {
+            std::cerr << "Corrupt record length " << recordLength << " at offset " << offset
+                      << " in " << fileName << ".\n";
+            return false;
+        }
+        offset += sizeof(recordLength) + recordLength;
+
+        std::string record(recordLength, '\0');
+        if (recordLength > 0 && !in.read(&record[0], recordLength)) return false;
+        if (!record.empty() && record[0] == ZipCodeDataFile::TOMBSTONE) continue;
+
+        snapshot.records.emplace_back();
+        snapshot.records.back().raw = std::move(record);
+    }
+    snapshot.keyOrdered = false;
+    return true;
+}
+
+bool loadDataFile(const std::string& fileName, Snapshot& snapshot) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error opening " << fileName << ".\n";
+        return false;
+    }
+    HeaderRecordBuffer header;
+    if (!header.readHeader(in)) {
+        std::cerr << "Error reading header of " << fileName << ".\n";
+        return false;
+    }
+
+    if (loadDataFileByIndex(fileName, header, snapshot)) {
+        hashRecords(snapshot);
+        // Every indexed record must parse back to its own key, else the index is stale
+        bool consistent = std::all_of(snapshot.records.begin(), snapshot.records.end(),
+                                      [](const SnapshotRecord& r) { return r.valid; });
+        if (consistent) return true;
+        snapshot.records.clear();
+    }
+
+    if (!loadDataFileByScan(in, fileName, snapshot)) return false;
+    hashRecords(snapshot);
+    return true;
+}
+
+bool loadSnapshot(const std::string& fileName, Snapshot& snapshot) {
+    bool isCsv = fileName.size() >= 4 && fileName.compare(fileName.size() - 4, 4, ".csv") == 0;
+    if (!isCsv) return loadDataFile(fileName, snapshot);
+
+    if (!loadCsv(fileName, snapshot)) return false;
+    hashRecords(snapshot);
+    return true;
+}
+
+void addChange(std::vector<ChangeRecord>& changes, ChangeRecord::Op op, const SnapshotRecord& r) {
+    ChangeRecord change;
+    change.op = op;
+    change.zip = r.zip;
+    if (op != ChangeRecord::REMOVED) change.record = r.normalized;
+    changes.push_back(std::move(change));
+}
+
+/**
+ * @brief Both sides sorted by ZIP code: a single merge pass, no hash table.
+ */
+void mergeJoin(const Snapshot& oldSide, const Snapshot& newSide, std::vector<ChangeRecord>& changes) {
+    const auto& a = oldSide.records;
+    const auto& b = newSide.records;
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        if (j == b.size() || (i < a.size() && a[i].zip < b[j].zip)) {
+            addChange(changes, ChangeRecord::REMOVED, a[i++]);
+        } else if (i == a.size() || b[j].zip < a[i].zip) {
+            addChange(changes, ChangeRecord::ADDED, b[j++]);
+        } else {
+            if (a[i].hash != b[j].hash || a[i].normalized != b[j].normalized) {
+                addChange(changes, ChangeRecord::CHANGED, b[j]);
+            }
+            ++i;
+            ++j;
+        }
+    }
+}
+
+/**
+ * @brief General case: build a table on the old side's ZIP codes, probe with the new.
+ *        A ZIP code listed twice counts once (the last occurrence wins).
+ */
+void hashJoin(const Snapshot& oldSide, const Snapshot& newSide, std::vector<ChangeRecord>& changes) {
+    std::unordered_map<std::string, size_t> oldByZip;
+    oldByZip.reserve(oldSide.records.size());
+    for (size_t i = 0; i < oldSide.records.size(); ++i) oldByZip[oldSide.records[i].zip] = i;
+
+    std::unordered_map<std::string, size_t> newByZip;
+    newByZip.reserve(newSide.records.size());
+    for (size_t j = 0; j < newSide.records.size(); ++j) newByZip[newSide.records[j].zip] = j;
+
+    for (const auto& entry : newByZip) {
+        const SnapshotRecord& r = newSide.records[entry.second];
+        auto it = oldByZip.find(entry.first);
+        if (it == oldByZip.end()) {
+            addChange(changes, ChangeRecord::ADDED, r);
+        } else {
+            const SnapshotRecord& old = oldSide.records[it->second];
+            if (old.hash != r.hash || old.normalized != r.normalized) addChange(changes, ChangeRecord::CHANGED, r);
+        }
+    }
+    for (const auto& entry : oldByZip) {
+        if (newByZip.count(entry.first) == 0) addChange(changes, ChangeRecord::REMOVED, oldSide.records[entry.second]);
+    }
+}
+
+/**
+ * @brief Drops records that failed to parse (e.g. CSV column headings).
+ */
+void dropInvalid(Snapshot& snapshot) {
+    auto& records = snapshot.records;
+    records.erase(std::remove_if(records.begin(), records.end(), [](const SnapshotRecord& r) { return !r.valid; }),
+                  records.end());
+}
+
+} // namespace
+
+bool diffSnapshots(const std::string& oldSnapshot, const std::string& newSnapshot,
+                   std::vector<ChangeRecord>& changes, bool* mergeJoined) {
+    Snapshot oldSide, newSide;
+    if (!loadSnapshot(oldSnapshot, oldSide) || !loadSnapshot(newSnapshot, newSide)) return false;
+    dropInvalid(oldSide);
+    dropInvalid(newSide);
+
+    changes.clear();
+    bool merge = oldSide.keyOrdered && newSide.keyOrdered;
+    if (mergeJoined) *mergeJoined = merge;
+    if (merge) {
+        mergeJoin(oldSide, newSide, changes);
+    } else {
+        hashJoin(oldSide, newSide, changes);
+        std::sort(changes.begin(), changes.end(),
+                  [](const ChangeRecord& x, const ChangeRecord& y) { return x.zip < y.zip; });
+    }
+    return true;
+}
+
+bool writeChangeset(const std::string& changesetFileName, const std::vector<ChangeRecord>& changes) {
+    std::ostringstream body;
+    body.write(CHANGESET_MAGIC, sizeof(CHANGESET_MAGIC));
+    uint32_t count = static_cast<uint32_t>(changes.size());
+    body.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const ChangeRecord& change : changes) {
+        char op = static_cast<char>(change.op);
+        uint16_t zipLength = static_cast<uint16_t>(change.zip.size());
+        uint32_t recordLength = static_cast<uint32_t>(change.record.size());
+        body.put(op);
+        body.write(reinterpret_cast<const char*>(&zipLength), sizeof(zipLength));
+        body.write(change.zip.data(), zipLength);
+        body.write(reinterpret_cast<const char*>(&recordLength), sizeof(recordLength));
+        body.write(change.record.data(), recordLength);
+    }
+
+    const std::string bytes = body.str();
+    uint32_t checksum = crc32c(bytes.data(), bytes.size());
+
+    std::ofstream out(changesetFileName, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error opening changeset file " << changesetFileName << " for writing.\n";
+        return false;
+    }
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    return static_cast<bool>(out);
+}
+
+bool readChangeset(const std::string& changesetFileName, std::vector<ChangeRecord>& changes) {
+    std::ifstream in(changesetFileName, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error opening changeset file " << changesetFileName << ".\n";
+        return false;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    const size_t minimum = sizeof(CHANGESET_MAGIC) + sizeof(uint32_t) + sizeof(uint32_t);
+    if (bytes.size() < minimum || bytes.compare(0, sizeof(CHANGESET_MAGIC), CHANGESET_MAGIC, sizeof(CHANGESET_MAGIC)) != 0) {
+        std::cerr << changesetFileName << " is not a changeset file.\n";
+        return false;
+    }
+    uint32_t stored;
+    size_t bodySize = bytes.size() - sizeof(stored);
+    std::memcpy(&stored, bytes.data() + bodySize, sizeof(stored));
+    if (crc32c(bytes.data(), bodySize) != stored) {
+        std::cerr << "Checksum mismatch in changeset file " << changesetFileName << ".\n";
+        return false;
+    }
+
+    std::istringstream body(bytes.substr(sizeof(CHANGESET_MAGIC), bodySize - sizeof(CHANGESET_MAGIC)));
+    uint32_t count = 0;
+    body.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+    changes.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        ChangeRecord change;
+        char op = 0;
+        uint16_t zipLength = 0;
+        uint32_t recordLength = 0;
+        if (!body.get(op) || !body.read(reinterpret_cast<char*>(&zipLength), sizeof(zipLength))) break;
+        change.zip.resize(zipLength);
+        if (zipLength > 0 && !body.read(&change.zip[0], zipLength)) break;
+        if (!body.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))) break;
+        if (recordLength > bodySize) break;
+        change.record.resize(recordLength);
+        if (recordLength > 0 && !body.read(&change.record[0], recordLength)) break;
+        if (op != ChangeRecord::ADDED && op != ChangeRecord::CHANGED && op != ChangeRecord::REMOVED) break;
+        change.op = static_cast<ChangeRecord::Op>(op);
+        changes.push_back(std::move(change));
+    }
+    if (changes.size() != count) {
+        std::cerr << "Malformed changeset file " << changesetFileName << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool applyChangeset(const std::vector<ChangeRecord>& changes, ZipCodeDataFile& dataFile,
+                    const std::function<void(const std::string& zip)>& onChanged) {
+    bool ok = true;
+    for (const ChangeRecord& change : changes) {
+        // Changesets carry ZIP codes without leading zeros, but the index keeps the
+        // source's spelling: act on the key as stored, or "00501" gains a twin "501"
+        std::string key = change.zip;
+        bool exists = dataFile.findKey(change.zip, key);
+        std::string record = change.record;
+        if (key != change.zip && record.compare(0, change.zip.size(), change.zip) == 0) {
+            record = key + record.substr(change.zip.size());
+        }
+
+        // Look at what's there now so re-applying a changeset is harmless and
+        // records that already match aren't touched (or invalidated)
+        std::string current, zip, normalized;
+        exists = exists && dataFile.read(key, current);
+        if (exists && change.op != ChangeRecord::REMOVED && normalizeRecord(current, zip, normalized) &&
+            normalized == change.record) {
+            continue;
+        }
+
+        bool applied = false;
+        if (change.op == ChangeRecord::REMOVED) {
+            if (!exists) continue;
+            applied = dataFile.remove(key);
+        } else {
+            applied = exists ? dataFile.update(record) : dataFile.insert(record);
+        }
+        if (!applied) {
+            std::cerr << "Could not apply change for ZIP code " << change.zip << ".\n";
+            ok = false;
+            continue;
+        }
+        if (onChanged) onChanged(key);
+    }
+    return ok;
+}
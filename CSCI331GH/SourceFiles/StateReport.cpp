@@ -0,0 +1,111 @@
+#include "StateReport.h"
+#include "ZipCodeRecordBuffer.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+bool computeStateExtremes(const string& csvFileName, map<string, StateRecord>& all_states) {
+    ZipCodeRecordBuffer buffer;
+    ifstream file(csvFileName);
+
+    if (!file.is_open()) {
+        cerr << "Error opening " << csvFileName << endl;
+        return false;
+    }
+
+    string header;
+    getline(file, header);
+
+    all_states.clear();
+    while (buffer.ReadRecord(file)) {
+        string state = buffer.getState();
+        string zip = buffer.getZipCode();
+        double latitude = buffer.getLatitude();
+        double longitude = buffer.getLongitude();
+
+        StateRecord& record = all_states[state];
+        if (longitude > record.easternmost_lon) { record.easternmost_lon = longitude; record.easternmost_zip = zip; }
+        if (longitude < record.westernmost_lon) { record.westernmost_lon = longitude; record.westernmost_zip = zip; }
+        if (latitude > record.northernmost_lat) { record.northernmost_lat = latitude; record.northernmost_zip = zip; }
+        if (latitude < record.southernmost_lat) { record.southernmost_lat = latitude; record.southernmost_zip = zip; }
+    }
+    file.close();
+    return true;
+}
+
+// Strings are written as <length>:<text>, so empty values and spaces survive the round trip
+static void writeField(ostream& out, const string& text) {
+    out << text.size() << ':' << text << ' ';
+}
+
+static bool readField(istream& in, size_t limit, string& text) {
+    size_t length = 0;
+    char colon = 0;
+    if (!(in >> length) || !in.get(colon) || colon != ':' || length > limit) return false;
+    text.assign(length, '\0');
+    return length == 0 || static_cast<bool>(in.read(&text[0], length));
+}
+
+// One line per state: state eastZip eastLon westZip westLon northZip northLat southZip southLat
+string serializeStateExtremes(const map<string, StateRecord>& all_states) {
+    ostringstream out;
+    out << setprecision(17);
+    for (const auto& pair : all_states) {
+        const StateRecord& r = pair.second;
+        writeField(out, pair.first);
+        writeField(out, r.easternmost_zip);
+        out << r.easternmost_lon << ' ';
+        writeField(out, r.westernmost_zip);
+        out << r.westernmost_lon << ' ';
+        writeField(out, r.northernmost_zip);
+        out << r.northernmost_lat << ' ';
+        writeField(out, r.southernmost_zip);
+        out << r.southernmost_lat << '\n';
+    }
+    return out.str();
+}
+
+bool deserializeStateExtremes(const string& payload, map<string, StateRecord>& all_states) {
+    istringstream in(payload);
+    all_states.clear();
+    while (in >> ws, in.peek() != char_traits<char>::eof()) {
+        string state;
+        StateRecord r;
+        if (!(readField(in, payload.size(), state)
+              && readField(in, payload.size(), r.easternmost_zip) && in >> r.easternmost_lon
+              && readField(in, payload.size(), r.westernmost_zip) && in >> r.westernmost_lon
+              && readField(in, payload.size(), r.northernmost_zip) && in >> r.northernmost_lat
+              && readField(in, payload.size(), r.southernmost_zip) && in >> r.southernmost_lat)) {
+            all_states.clear();
+            return false;
+        }
+        all_states[state] = r;
+    }
+    return true;
+}
+
+void printStateExtremes(const map<string, StateRecord>& all_states) {
+// Extreme headers for zipcode project 1
+    // Print state extremes summary
+    cout << left << setw(8) << "State"
+         << setw(15) << "Easternmost"
+         << setw(15) << "Westernmost"
+         << setw(15) << "Northernmost"
+         << setw(15) << "Southernmost"
+         << "\n";
+    cout << string(68, '-') << "\n";
+
+    for (const auto& pair : all_states) {
+        const auto& record = pair.second;
+        cout << left << setw(8) << pair.first
+             << setw(15) << record.easternmost_zip
+             << setw(15) << record.westernmost_zip
+             << setw(15) << record.northernmost_zip
+             << setw(15) << record.southernmost_zip
+             << "\n";
+    }
+}
@@ -0,0 +1,514 @@
+#include "ZipCodeDataFile.h"
+#include "ZipCodeRecordBuffer.h"
+#include "BlockChecksums.h"
+#include "FileReplace.h"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+// Tombstone body: [TOMBSTONE:char][next avail offset:uint64_t]
+static const uint32_t TOMBSTONE_SIZE = sizeof(char) + sizeof(uint64_t);
+
+// Background compactions that lost a race with an edit before one runs under the lock
+static const int COMPACTION_ATTEMPTS = 3;
+
+static void trimPadding(std::string& record) {
+    record.erase(record.find_last_not_of(' ') + 1);
+}
+
+ZipCodeDataFile::~ZipCodeDataFile() {
+    waitForCompaction();
+    close();
+}
+
+bool ZipCodeDataFile::open(const std::string& dataFileName) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return openLocked(dataFileName);
+}
+
+bool ZipCodeDataFile::openLocked(const std::string& dataFileName) {
+    fileName = dataFileName;
+    ++editGeneration; // a compaction of a previously opened file must not swap in here
+    if (!reopenLocked()) return false;
+
+    // Older files have no room for the avail list in their header
+    if (header.version < 3) {
+        std::cout << "Upgrading " << fileName << " to header version 3...\n";
+        return compactLocked();
+    }
+
+    // The index path is shared between data files, so make sure it was written for this one
+    if (!index.readIndex(header.indexFileName) || index.size() != header.recordCount || !index.belongsTo(fileName)) {
+        std::cout << "Index missing or stale — rebuilding from " << fileName << "...\n";
+        if (!index.buildIndex(fileName)) return false;
+        index.writeIndex(header.indexFileName, fileName);
+    }
+    return true;
+}
+
+/**
+ * @brief Opens fileName and reads its header and extent. Caller must hold fileMutex.
+ */
+bool ZipCodeDataFile::reopenLocked() {
+    file.clear();
+    file.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open " << fileName << " for editing.\n";
+        return false;
+    }
+
+    if (!header.readHeader(file)) {
+        std::cerr << "Error reading header of " << fileName << ".\n";
+        file.close();
+        return false;
+    }
+    dataStart = static_cast<uint64_t>(file.tellg());
+    file.seekg(0, std::ios::end);
+    fileEnd = static_cast<uint64_t>(file.tellg());
+    return true;
+}
+
+bool ZipCodeDataFile::close() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (!file.is_open()) return true;
+
+    flushHeader();
+    file.close();
+    index.writeIndex(header.indexFileName, fileName); // stamped with the file as closed
+
+    // Edits since open() discarded the old checksums
+    bool missing = !std::ifstream(BlockChecksums::sidecarName(fileName)).is_open();
+    if (!checksumsStale && !missing) return true;
+    checksumsStale = false;
+    return BlockChecksums::write(fileName);
+}
+
+/**
+ * @brief Validates a CSV record with ZipCodeRecordBuffer and extracts its ZIP code.
+ */
+bool ZipCodeDataFile::parseZip(const std::string& csvRecord, std::string& zip) {
+    ZipCodeRecordBuffer buffer;
+    std::istringstream ss(csvRecord);
+    if (!buffer.ReadRecord(ss)) {
+        std::cerr << "Error: '" << csvRecord << "' is not a valid ZIP code record.\n";
+        return false;
+    }
+    zip = buffer.getZipCode();
+    return true;
+}
+
+bool ZipCodeDataFile::insert(const std::string& csvRecord) {
+    std::string zip;
+    if (!parseZip(csvRecord, zip)) return false;
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::string existing;
+    if (index.findKey(zip, existing)) {
+        std::cerr << "Error: ZIP code " << zip << " already exists as " << existing << ".\n";
+        return false;
+    }
+    if (!beginEdit()) return false;
+
+    uint64_t offset = 0;
+    if (!placeRecord(csvRecord, offset)) return false;
+
+    index.setOffset(zip, offset);
+    ++header.recordCount;
+    flushHeader();
+    return true;
+}
+
+bool ZipCodeDataFile::update(const std::string& csvRecord) {
+    std::string zip;
+    if (!parseZip(csvRecord, zip)) return false;
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::string key;
+    if (!index.findKey(zip, key)) {
+        std::cerr << "Error: ZIP code " << zip << " not found.\n";
+        return false;
+    }
+    uint64_t offset = index.findOffset(key);
+
+    uint32_t slotLength = 0;
+    file.seekg(offset, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(&slotLength), sizeof(slotLength))) return false;
+    if (!beginEdit()) return false;
+
+    // Fits in the existing slot: overwrite in place, padding out the remainder
+    if (csvRecord.size() <= slotLength) {
+        return writeRecordAt(offset, slotLength, csvRecord);
+    }
+
+    // Otherwise relocate: write the new copy first, then tombstone the old slot
+    uint64_t newOffset = 0;
+    if (!placeRecord(csvRecord, newOffset)) return false;
+    tombstone(offset);
+    index.setOffset(key, newOffset);
+
+    flushHeader();
+    maybeCompact();
+    return true;
+}
+
+bool ZipCodeDataFile::remove(const std::string& zip) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::string key;
+    if (!index.findKey(zip, key)) {
+        std::cerr << "Error: ZIP code " << zip << " not found.\n";
+        return false;
+    }
+    uint64_t offset = index.findOffset(key);
+    if (!beginEdit()) return false;
+
+    if (!tombstone(offset)) return false;
+    index.erase(key);
+    --header.recordCount;
+
+    flushHeader();
+    maybeCompact();
+    return true;
+}
+
+bool ZipCodeDataFile::findKey(const std::string& zip, std::string& storedKey) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return index.findKey(zip, storedKey);
+}
+
+bool ZipCodeDataFile::read(const std::string& zip, std::string& csvRecord) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::string key;
+    if (!index.findKey(zip, key)) return false;
+    uint64_t offset = index.findOffset(key);
+
+    uint32_t recordLength = 0;
+    file.seekg(offset, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))) return false;
+    if (recordLength > fileEnd - offset - sizeof(recordLength)) {
+        std::cerr << "Error: record for ZIP code " << zip << " overruns " << fileName << ".\n";
+        return false;
+    }
+
+    csvRecord.assign(recordLength, '\0');
+    if (!file.read(&csvRecord[0], recordLength)) return false;
+    trimPadding(csvRecord);
+    return true;
+}
+
+/**
+ * @brief Writes a record into a slot of @p slotLength bytes, space-padding any
+ *        leftover room (ZipCodeRecordBuffer trims it when parsing).
+ */
+bool ZipCodeDataFile::writeRecordAt(uint64_t offset, uint32_t slotLength, const std::string& record) {
+    std::string body = record;
+    body.resize(slotLength, ' ');
+
+    file.seekp(offset, std::ios::beg);
+    file.write(reinterpret_cast<const char*>(&slotLength), sizeof(slotLength));
+    file.write(body.data(), slotLength);
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Stores a record in the first tombstone large enough, or at end of file.
+ */
+bool ZipCodeDataFile::placeRecord(const std::string& record, uint64_t& offset) {
+    uint32_t needed = static_cast<uint32_t>(record.size());
+    uint32_t slotLength = 0;
+
+    if (takeFromAvailList(needed, offset, slotLength)) {
+        header.deadBytes -= sizeof(slotLength) + slotLength;
+        return writeRecordAt(offset, slotLength, record);
+    }
+
+    offset = fileEnd;
+    if (!writeRecordAt(offset, needed, record)) return false;
+    fileEnd += sizeof(needed) + needed;
+    return true;
+}
+
+/**
+ * @brief First-fit search of the avail list; unlinks the slot it returns.
+ */
+bool ZipCodeDataFile::takeFromAvailList(uint32_t needed, uint64_t& offset, uint32_t& slotLength) {
+    uint64_t previous = NO_RECORD;
+    uint64_t current = header.availListHead;
+
+    while (current != NO_RECORD) {
+        uint32_t length = 0;
+        char mark = 0;
+        uint64_t next = NO_RECORD;
+
+        file.seekg(current, std::ios::beg);
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        file.read(&mark, sizeof(mark));
+        file.read(reinterpret_cast<char*>(&next), sizeof(next));
+        if (!file || mark != TOMBSTONE) {
+            std::cerr << "Error: avail list of " << fileName << " is corrupt at offset " << current << ".\n";
+            file.clear();
+            return false;
+        }
+
+        if (length >= needed) {
+            if (previous == NO_RECORD) {
+                header.availListHead = next;
+            } else {
+                file.seekp(previous + sizeof(uint32_t) + sizeof(char), std::ios::beg);
+                file.write(reinterpret_cast<const char*>(&next), sizeof(next));
+            }
+            offset = current;
+            slotLength = length;
+            return true;
+        }
+
+        previous = current;
+        current = next;
+    }
+    return false;
+}
+
+/**
+ * @brief Marks the record at @p offset deleted and pushes it on the avail list.
+ *
+ * Slots too small to hold the next-pointer are marked but never reused; they
+ * are reclaimed by compaction.
+ */
+bool ZipCodeDataFile::tombstone(uint64_t offset) {
+    uint32_t slotLength = 0;
+    file.seekg(offset, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(&slotLength), sizeof(slotLength))) return false;
+
+    file.seekp(offset + sizeof(slotLength), std::ios::beg);
+    file.write(&TOMBSTONE, sizeof(TOMBSTONE));
+    if (slotLength >= TOMBSTONE_SIZE) {
+        file.write(reinterpret_cast<const char*>(&header.availListHead), sizeof(header.availListHead));
+        header.availListHead = offset;
+    }
+
+    header.deadBytes += sizeof(slotLength) + slotLength;
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Called before the first change to the file: its checksum sidecar is
+ *        about to be wrong, so remove it rather than let it report corruption.
+ */
+bool ZipCodeDataFile::beginEdit() {
+    ++editGeneration;
+    if (checksumsStale) return true;
+    if (!BlockChecksums::discard(fileName)) return false;
+    checksumsStale = true;
+    return true;
+}
+
+void ZipCodeDataFile::flushHeader() {
+    file.seekp(0, std::ios::beg);
+    header.rewriteHeader(file);
+    file.flush();
+}
+
+double ZipCodeDataFile::deadSpaceRatio() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    uint64_t recordArea = fileEnd - dataStart;
+    return recordArea == 0 ? 0.0 : static_cast<double>(header.deadBytes) / recordArea;
+}
+
+uint64_t ZipCodeDataFile::recordCount() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return header.recordCount;
+}
+
+IndexManager ZipCodeDataFile::indexSnapshot() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return index;
+}
+
+/**
+ * @brief Starts a background compaction if the dead-space ratio crossed the
+ *        threshold. Caller must hold fileMutex.
+ *
+ * The compactor takes the lock twice: to copy the live records, and to swap the
+ * rewritten file in. Reads and edits go ahead while it writes the new file; if
+ * any edit landed meanwhile, the copy is out of date and is thrown away. After
+ * COMPACTION_ATTEMPTS such races it compacts under the lock so it still finishes.
+ */
+void ZipCodeDataFile::maybeCompact() {
+    if (compactionThreshold > 1.0 || compacting) return;
+
+    uint64_t recordArea = fileEnd - dataStart;
+    if (recordArea == 0 || static_cast<double>(header.deadBytes) / recordArea < compactionThreshold) return;
+
+    // A previous compactor has already released the mutex, so this join is quick
+    if (compactor.joinable()) compactor.join();
+
+    compacting = true;
+    compactor = std::thread([this]() {
+        for (int attempt = 1; ; ++attempt) {
+            std::vector<std::string> records;
+            HeaderRecordBuffer snapshotHeader;
+            std::string tempName;
+            uint64_t generation = 0;
+            {
+                std::lock_guard<std::mutex> lock(fileMutex);
+                if (!file.is_open()) break;
+                if (attempt > COMPACTION_ATTEMPTS) {
+                    compactLocked();
+                    break;
+                }
+                if (!collectLiveRecords(records)) break;
+                snapshotHeader = header;
+                tempName = fileName + ".compact";
+                generation = editGeneration;
+            }
+
+            IndexManager newIndex;
+            if (!writeCompacted(tempName, snapshotHeader, records, newIndex)) break;
+
+            std::lock_guard<std::mutex> lock(fileMutex);
+            if (generation == editGeneration && file.is_open()) {
+                swapInCompacted(tempName, newIndex);
+                break;
+            }
+            std::remove(tempName.c_str());
+        }
+        compacting = false;
+    });
+}
+
+void ZipCodeDataFile::waitForCompaction() {
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        finished = std::move(compactor);
+    }
+    if (finished.joinable()) finished.join();
+}
+
+bool ZipCodeDataFile::compact() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    return compactLocked();
+}
+
+/**
+ * @brief Copies live records, in file order, into a fresh file and swaps it in.
+ *
+ * Padding left behind by in-place updates is dropped, and the new index is
+ * collected during the copy instead of rescanning the result.
+ */
+bool ZipCodeDataFile::compactLocked() {
+    std::vector<std::string> records;
+    if (!collectLiveRecords(records)) return false;
+
+    IndexManager newIndex;
+    const std::string tempName = fileName + ".compact";
+    if (!writeCompacted(tempName, header, records, newIndex)) return false;
+    return swapInCompacted(tempName, newIndex);
+}
+
+/**
+ * @brief Reads every live record, padding trimmed, in file order. Caller must hold
+ *        fileMutex. Fails rather than return a partial copy if a length is corrupt.
+ */
+bool ZipCodeDataFile::collectLiveRecords(std::vector<std::string>& records) {
+    file.clear();
+    file.seekg(dataStart, std::ios::beg);
+
+    uint64_t offset = dataStart;
+    while (offset < fileEnd) {
+        uint32_t recordLength = 0;
+        if (fileEnd - offset < sizeof(recordLength)
+            || !file.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))
+            || recordLength > fileEnd - offset - sizeof(recordLength)) {
+            std::cerr << "Error: " << fileName << " is corrupt at offset " << offset << "; not compacting.\n";
+            file.clear();
+            return false;
+        }
+
+        std::string record(recordLength, '\0');
+        if (!file.read(&record[0], recordLength)) {
+            std::cerr << "Error reading " << fileName << " at offset " << offset << "; not compacting.\n";
+            file.clear();
+            return false;
+        }
+        offset += sizeof(recordLength) + recordLength;
+
+        if (!record.empty() && record[0] == TOMBSTONE) continue;
+        trimPadding(record);
+        records.push_back(std::move(record));
+    }
+    return true;
+}
+
+/**
+ * @brief Writes @p records to a new version 3 file and indexes them. Needs no lock.
+ */
+bool ZipCodeDataFile::writeCompacted(const std::string& tempName, HeaderRecordBuffer newHeader,
+                                     const std::vector<std::string>& records, IndexManager& newIndex) {
+    std::ofstream out(tempName, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Cannot open " << tempName << " for compaction.\n";
+        return false;
+    }
+
+    newHeader.version = 3;
+    newHeader.availListHead = NO_RECORD;
+    newHeader.deadBytes = 0;
+    newHeader.recordCount = 0;
+    newHeader.rewriteHeader(out);
+
+    for (const std::string& record : records) {
+        uint64_t newOffset = static_cast<uint64_t>(out.tellp());
+        uint32_t newLength = static_cast<uint32_t>(record.size());
+        out.write(reinterpret_cast<const char*>(&newLength), sizeof(newLength));
+        out.write(record.data(), newLength);
+
+        std::string zip;
+        if (IndexManager::recordKey(record, zip)) {
+            newIndex.setOffset(zip, newOffset);
+        }
+        ++newHeader.recordCount;
+    }
+
+    // Header size doesn't change, so the final count can be patched in place
+    out.seekp(0, std::ios::beg);
+    newHeader.rewriteHeader(out);
+    out.close();
+    if (!out) {
+        std::cerr << "Error writing " << tempName << ".\n";
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Renames the compacted copy over the data file and reopens it. Caller must
+ *        hold fileMutex. If the rename fails the original file stays in use.
+ */
+bool ZipCodeDataFile::swapInCompacted(const std::string& tempName, const IndexManager& newIndex) {
+    // The old sidecar must not outlive the file it describes, even across a crash
+    if (!BlockChecksums::discard(fileName)) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    checksumsStale = true;
+    file.close();
+    if (!replaceFile(tempName, fileName)) {
+        std::remove(tempName.c_str());
+        reopenLocked();
+        return false;
+    }
+
+    if (!reopenLocked()) {
+        std::cerr << "Error reopening " << fileName << " after compaction.\n";
+        return false;
+    }
+
+    index = newIndex;
+    index.writeIndex(header.indexFileName, fileName);
+    file.flush();
+    if (!BlockChecksums::write(fileName)) return false;
+    checksumsStale = false;
+    return true;
+}
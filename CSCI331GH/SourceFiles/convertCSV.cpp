@@ -4,10 +4,8 @@
 #include <string>
 #include "convertCSV.h"
 #include "readBinaryFile.h"
-#include "HeaderBuffer.h"
-#include "IndexManager.h"
-#include <algorithm>
-#include <cctype>
+#include "DataFileWriter.h"
+#include "ExternalSort.h"
 using namespace std;
 
 //Authors: Team 5
@@ -15,60 +13,38 @@ using namespace std;
 /*Purpose: This file contains the implementation of functions to read a CSV file and
  write its contents to a binary file with length-prefixed records. */
 
-void processFile(string& inputFileName, const string& outputFileName) {
-    ifstream inputFile(inputFileName);
-    ofstream outputFile(outputFileName, ios::binary);
+void processFile(string& inputFileName, const string& outputFileName, size_t sortMemoryBudget) {
+    if (sortMemoryBudget > 0) {
+        if (externalSortToDataFile(inputFileName, outputFileName, "Data/zip.idx", sortMemoryBudget)) {
+            cout << "Key-ordered binary file and index created successfully." << endl;
+        }
+        return;
+    }
 
-    if (!inputFile.is_open() || !outputFile.is_open()) {
+    ifstream inputFile(inputFileName);
+    if (!inputFile.is_open()) {
         cerr << "Error opening files in processFile." << endl;
         return;
     }
 
-    HeaderRecordBuffer header;
-    
-    // Set all the metadata
-    header.version = 2; 
-    header.indexFileName = "Data/zip.idx";
-    header.primaryKeyFieldIndex = 0; 
-    
-    
-    header.fields.push_back({"ZipCode", DataType::STRING});
-    header.fields.push_back({"PlaceName", DataType::STRING});
-    header.fields.push_back({"State", DataType::STRING});
-    header.fields.push_back({"County", DataType::STRING});
-    header.fields.push_back({"Latitude", DataType::DOUBLE});
-    header.fields.push_back({"Longitude", DataType::DOUBLE});
-
-    uint32_t recordCount = 0;
-    string tempLine;
-    getline(inputFile, tempLine); 
-    while (std::getline(inputFile, tempLine)) {
-        if (!tempLine.empty()) {
-            ++recordCount;
-        }
+    // Writes the header, the records and the index (built in the same pass)
+    DataFileWriter writer;
+    if (!writer.open(outputFileName, "Data/zip.idx")) {
+        return;
     }
-    header.recordCount = recordCount; // Set the count
- 
-    header.writeHeader(outputFile);
-
-    inputFile.clear();
-    inputFile.seekg(0, std::ios::beg);
-    getline(inputFile, tempLine); 
 
     string line;
+    getline(inputFile, line); // skip the CSV header row
     while (getline(inputFile, line)) {
         if (!line.empty()) {
-            lenRead(outputFile, line); 
+            writer.append(line);
         }
     }
-    
-
-    IndexManager index;
-    index.buildIndex(outputFileName); 
-    index.writeIndex(header.indexFileName); // Use the filename from the header
 
     inputFile.close();
-    outputFile.close();
+    if (!writer.close()) {
+        return;
+    }
     cout << "Binary file and index created successfully with new header format." << endl;
 }
 
@@ -79,12 +55,12 @@ void lenRead(ofstream& output, const string& record) {
     output.write(record.c_str(), recordLength);
 }
 
-void binaryToCSV() {
-    string inputCSVFileName = "Data/us_postal_codes.csv";
+void binaryToCSV(const string& inputCSVFileName, size_t sortMemoryBudget) {
+    string inputFileName = inputCSVFileName;
     string binaryFile = "Data/newBinaryPCodes.dat";
 	string outputCSVFile = "Data/converted_postal_codes.csv";
 
-    processFile(inputCSVFileName, binaryFile);
+    processFile(inputFileName, binaryFile, sortMemoryBudget);
 	readBinaryFile(binaryFile, outputCSVFile);
 
 }
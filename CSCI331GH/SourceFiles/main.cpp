@@ -1,142 +1,457 @@
 #include <map>
+#include <vector>
 #include <iomanip>
 #include <string>
 #include <iostream>
 #include <limits> // For numeric_limits
 #include <sstream>
 #include <fstream>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cctype>
+#include <memory>
 #include "ZipCodeRecordBuffer.h"
 #include "HeaderBuffer.h"
 #include "convertCSV.h"
 #include "IndexManager.h"
+#include "ConcurrentIndex.h"
+#include "ExternalSort.h"
+#include "ResultCache.h"
+#include "StateReport.h"
+#include "AsyncRecordFetcher.h"
+#include "HotRecordCache.h"
+#include "BlockChecksums.h"
+#include "Crc32c.h"
+#include "SnapshotDiff.h"
+#include "ZipCodeDataFile.h"
+#include "readBinaryFile.h"
+#include "ShardedDataSet.h"
 
 using namespace std;
 
-// Struct to hold the four extreme zip codes for each state
-struct StateRecord {
-    string easternmost_zip;
-    double easternmost_lon = -numeric_limits<double>::max();
-    string westernmost_zip;
-    double westernmost_lon = numeric_limits<double>::max();
-    string northernmost_zip;
-    double northernmost_lat = -numeric_limits<double>::max();
-    string southernmost_zip;
-    double southernmost_lat = numeric_limits<double>::max();
-};
+/**
+ * @brief Parses the value of a numeric --name=N flag, reporting a usage error if
+ *        it isn't a whole number in [minimum, maximum].
+ */
+static bool parseNumberFlag(const string& arg, size_t prefixLength, size_t minimum, size_t maximum, size_t& value) {
+    string text = arg.substr(prefixLength);
+    bool digits = !text.empty() && text.size() <= 19 && all_of(text.begin(), text.end(), [](unsigned char c) {
+        return isdigit(c);
+    });
+    if (digits) {
+        unsigned long long parsed = stoull(text);
+        if (parsed >= minimum && parsed <= maximum) {
+            value = static_cast<size_t>(parsed);
+            return true;
+        }
+    }
+    cerr << "Error: " << arg.substr(0, prefixLength - 1) << " expects a whole number from " << minimum
+         << " to " << maximum << ", got '" << text << "'.\n";
+    return false;
+}
+
+/**
+ * @brief Parses the "<low>-<high>" ZIP bounds of --range, reporting a usage error
+ *        if they aren't whole numbers with low <= high.
+ */
+static bool parseZipRange(const string& text, uint32_t& low, uint32_t& high) {
+    auto isZip = [](const string& zip) {
+        return !zip.empty() && zip.size() <= 9 && all_of(zip.begin(), zip.end(), [](unsigned char c) {
+            return isdigit(c);
+        });
+    };
+    size_t dash = text.find('-');
+    if (dash != string::npos && isZip(text.substr(0, dash)) && isZip(text.substr(dash + 1))) {
+        low = static_cast<uint32_t>(stoul(text.substr(0, dash)));
+        high = static_cast<uint32_t>(stoul(text.substr(dash + 1)));
+        if (low <= high) return true;
+    }
+    cerr << "Error: --range expects <low>-<high> ZIP codes, got '" << text << "'.\n";
+    return false;
+}
+
+/**
+ * @brief Builds a new index snapshot off to the side and publishes it, so lookups
+ *        never see a half-loaded map. An index file written for a different data
+ *        file is ignored and the data file is rescanned instead.
+ * @return False (keeping the current snapshot) if neither source can be read.
+ */
+static bool publishIndex(ConcurrentIndex& index, const string& indexFile, const string& binaryFile) {
+    unique_ptr<IndexManager> next(new IndexManager());
+    if (!next->readIndex(indexFile) || !next->belongsTo(binaryFile)) {
+        next.reset(new IndexManager());
+        if (!next->buildIndex(binaryFile)) return false;
+    }
+    index.publish(std::move(next));
+    return true;
+}
+
+/**
+ * @brief Applies a changeset file to the data file and its index in place.
+ * @param onChanged Called with each ZIP code actually modified (may be empty).
+ * @return False if the changeset or data file couldn't be read, or a change failed.
+ */
+static bool applyChangesetFile(const string& changesetFile, const string& binaryFile,
+                               const function<void(const string&)>& onChanged) {
+    vector<ChangeRecord> changes;
+    if (!readChangeset(changesetFile, changes)) return false;
+
+    ZipCodeDataFile dataFile;
+    if (!dataFile.open(binaryFile)) return false;
+    size_t applied = 0;
+    bool ok = applyChangeset(changes, dataFile, [&](const string& zip) {
+        if (onChanged) onChanged(zip);
+        ++applied;
+    });
+    dataFile.waitForCompaction();
+    ok = dataFile.close() && ok;
+    cout << "Applied " << applied << " of " << changes.size() << " changes from " << changesetFile << ".\n";
+
+    // The state report is a whole-file aggregate: refresh its source only when
+    // something changed, and the report cache notices the new fingerprint
+    if (applied > 0) readBinaryFile(binaryFile, "Data/converted_postal_codes.csv");
+    return ok;
+}
 
 int main(int argc, char* argv[]) {
     // --- Step 1: Ensure binary and index exist ---
     const string binaryFile = "Data/newBinaryPCodes.dat";
     const string indexFile = "Data/zip.idx";
 
+    // Ingest options: --rebuild, --source=<csv>, --sort-by-key, --sort-memory=<MB>
+    // Lookup options: --queue-depth=<N>, --cache-size=<N> (0 disables the cache)
+    // Integrity options: --verify, --verify-lookups
+    // Changeset options: --diff=<old>,<new>, --changeset=<file>, --apply=<file>
+    // Shard options: --build-shards=<manifest>, --shard-digits=<1-4>, --shard-dir=<dir> (repeatable),
+    //                --shards=<manifest> (serve -Z lookups from shards), --rebuild-shard=<prefix>,
+    //                --range=<low>-<high>, --state-counts (queries fanned out over the shards)
+    bool forceRebuild = false;
+    bool verifyOnly = false;
+    bool verifyLookups = false;
+    string sourceCSV = "Data/us_postal_codes.csv";
+    bool sortByKey = false;
+    size_t sortMemoryMB = DEFAULT_SORT_MEMORY / (1024 * 1024);
+    string diffPair;
+    string changesetFile = "Data/changes.delta";
+    string applyFile;
+    size_t queueDepth = 32;
+    size_t cacheSize = 4096;
+    string buildShardsManifest;
+    string shardsManifest;
+    string rebuildShardPrefix;
+    size_t shardDigits = 1;
+    vector<string> shardDirectories;
+    bool rangeRequested = false;
+    uint32_t rangeLow = 0;
+    uint32_t rangeHigh = 0;
+    bool stateCounts = false;
+    vector<string> ingestFlags;   // only take effect when the data file is (re)built
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--rebuild") forceRebuild = true;
+        else if (arg.rfind("--source=", 0) == 0) {
+            sourceCSV = arg.substr(9);
+            ingestFlags.push_back("--source");
+        }
+        else if (arg == "--sort-by-key") {
+            sortByKey = true;
+            ingestFlags.push_back("--sort-by-key");
+        }
+        else if (arg.rfind("--sort-memory=", 0) == 0) {
+            if (!parseNumberFlag(arg, 14, 1, 1024 * 1024, sortMemoryMB)) return 1;
+            ingestFlags.push_back("--sort-memory");
+        }
+        else if (arg.rfind("--queue-depth=", 0) == 0) {
+            if (!parseNumberFlag(arg, 14, 1, 4096, queueDepth)) return 1;
+        }
+        else if (arg.rfind("--cache-size=", 0) == 0) {
+            if (!parseNumberFlag(arg, 13, 0, size_t(1) << 30, cacheSize)) return 1;
+        }
+        else if (arg == "--verify") verifyOnly = true;
+        else if (arg == "--verify-lookups") verifyLookups = true;
+        else if (arg.rfind("--diff=", 0) == 0) diffPair = arg.substr(7);
+        else if (arg.rfind("--changeset=", 0) == 0) changesetFile = arg.substr(12);
+        else if (arg.rfind("--apply=", 0) == 0) applyFile = arg.substr(8);
+        else if (arg.rfind("--build-shards=", 0) == 0) buildShardsManifest = arg.substr(15);
+        else if (arg.rfind("--shard-digits=", 0) == 0) {
+            if (!parseNumberFlag(arg, 15, 1, 4, shardDigits)) return 1;
+        }
+        else if (arg.rfind("--shard-dir=", 0) == 0) shardDirectories.push_back(arg.substr(12));
+        else if (arg.rfind("--shards=", 0) == 0) shardsManifest = arg.substr(9);
+        else if (arg.rfind("--rebuild-shard=", 0) == 0) rebuildShardPrefix = arg.substr(16);
+        else if (arg.rfind("--range=", 0) == 0) {
+            if (!parseZipRange(arg.substr(8), rangeLow, rangeHigh)) return 1;
+            rangeRequested = true;
+        }
+        else if (arg == "--state-counts") stateCounts = true;
+    }
+    size_t sortMemoryBudget = sortByKey ? sortMemoryMB * 1024 * 1024 : 0; // 0 = keep input order
+
+    // --- Sharded layout: built and queried on its own, without the monolithic file ---
+    if (!buildShardsManifest.empty()) {
+        return ShardedDataSet::build(sourceCSV, buildShardsManifest, static_cast<int>(shardDigits),
+                                     shardDirectories) ? 0 : 1;
+    }
+    if ((!rebuildShardPrefix.empty() || rangeRequested || stateCounts) && shardsManifest.empty()) {
+        cerr << "Usage: --shards=<manifest> [--rebuild-shard=<prefix> [--source=<csv>]] "
+             << "[--range=<low>-<high>] [--state-counts] [-Z<zip>...]\n";
+        return 1;
+    }
+    if (!shardsManifest.empty()) {
+        ShardedDataSet shards;
+        if (!shards.open(shardsManifest)) return 1;
+        if (!rebuildShardPrefix.empty() && !shards.rebuildShard(rebuildShardPrefix, sourceCSV)) return 1;
+
+        cout << "\n--- ZIP Code Search Results (" << shards.shardCount() << " shards) ---\n";
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg.rfind("-Z", 0) != 0 || arg.size() <= 2) continue;
+
+            string zipInput = arg.substr(2);
+            string record;
+            if (!shards.findRecord(zipInput, record)) {
+                cout << "ZIP code " << zipInput << " not found.\n";
+                continue;
+            }
+
+            ZipCodeRecordBuffer zipBuffer;
+            istringstream ss(record);
+            if (!zipBuffer.ReadRecord(ss)) {
+                cerr << "Error parsing record for ZIP code " << zipInput << endl;
+                continue;
+            }
+            cout << "---------------------------------------------\n";
+            cout << HotRecordCache::render(zipBuffer);
+        }
+
+        // Range and aggregate queries run on every relevant shard in parallel
+        bool complete = true;
+        if (rangeRequested) {
+            vector<string> records;
+            complete = shards.rangeQuery(rangeLow, rangeHigh, records) && complete;
+            cout << "\n--- ZIP Codes " << rangeLow << " to " << rangeHigh << " (" << records.size()
+                 << " records) ---\n";
+            for (const string& record : records) cout << record << "\n";
+        }
+        if (stateCounts) {
+            map<string, size_t> counts;
+            complete = shards.aggregate(counts,
+                [](map<string, size_t>& partial, const ZipCodeRecordBuffer& record) { ++partial[record.getState()]; },
+                [](map<string, size_t>& total, const map<string, size_t>& partial) {
+                    for (const auto& state : partial) total[state.first] += state.second;
+                }) && complete;
+            cout << "\n--- Records per State ---\n";
+            for (const auto& state : counts) cout << left << setw(4) << state.first << state.second << "\n";
+        }
+        if (!complete) {
+            cerr << "Error: some shards could not be read; the results above are incomplete.\n";
+            return 1;
+        }
+        return 0;
+    }
+
     ifstream testBin(binaryFile, ios::binary);
-    if (!testBin.good()) {
-        cout << "Binary or index missing — rebuilding from CSV...\n";
-        binaryToCSV(); // creates zip_len.dat and zip.idx
+    if (!testBin.good() || forceRebuild) {
+        cout << "Rebuilding binary and index from " << sourceCSV << "...\n";
+        binaryToCSV(sourceCSV, sortMemoryBudget); // creates zip_len.dat and zip.idx
+    } else if (!ingestFlags.empty()) {
+        cerr << "Warning: " << binaryFile << " already exists, so ";
+        for (size_t i = 0; i < ingestFlags.size(); ++i) cerr << (i ? ", " : "") << ingestFlags[i];
+        cerr << (ingestFlags.size() == 1 ? " has" : " have") << " no effect; add --rebuild to re-ingest with "
+             << (ingestFlags.size() == 1 ? "it" : "them") << ".\n";
     }
     testBin.close();
 
-    // --- Part 1: Compute state extremes (from converted CSV) ---
-    map<string, StateRecord> all_states;
-    ZipCodeRecordBuffer buffer;
-    ifstream file("Data/converted_postal_codes.csv");
+    // --- Snapshot diff: compare two datasets, write a changeset, then exit ---
+    if (!diffPair.empty()) {
+        size_t comma = diffPair.find(',');
+        if (comma == string::npos) {
+            cerr << "Usage: --diff=<old.csv|old.dat>,<new.csv|new.dat>\n";
+            return 1;
+        }
+        auto start = chrono::steady_clock::now();
+        vector<ChangeRecord> changes;
+        bool mergeJoined = false;
+        if (!diffSnapshots(diffPair.substr(0, comma), diffPair.substr(comma + 1), changes, &mergeJoined) ||
+            !writeChangeset(changesetFile, changes)) {
+            return 1;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    if (!file.is_open()) {
-        cerr << "Error opening Data/converted_postal_codes.csv" << endl;
-        return 1;
+        size_t counts[3] = {0, 0, 0};
+        for (const ChangeRecord& change : changes) {
+            counts[change.op == ChangeRecord::ADDED ? 0 : change.op == ChangeRecord::CHANGED ? 1 : 2]++;
+        }
+        cout << "Wrote " << changes.size() << " changes to " << changesetFile << " (" << counts[0] << " added, "
+             << counts[1] << " changed, " << counts[2] << " removed) in " << fixed << setprecision(3)
+             << seconds << " s (" << (mergeJoined ? "merge" : "hash") << " join).\n";
+        return 0;
     }
 
-    string header;
-    getline(file, header);
+    // --- Integrity check: every block of the data file plus the index, then exit ---
+    if (verifyOnly) {
+        BlockChecksums checksums;
+        bool ok = checksums.load(binaryFile);
+        if (!ok) {
+            // Editors remove the sidecar until they close the file, so this isn't corruption
+            cerr << "No valid checksums for " << binaryFile << " (missing, or the file was edited and not "
+                 << "closed cleanly); they are rewritten on the next clean close or --rebuild.\n";
+        } else {
+            auto start = chrono::steady_clock::now();
+            ok = checksums.verifyFile(binaryFile);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << "Checked " << binaryFile << " in " << fixed << setprecision(3) << seconds << " s ("
+                 << (crc32cIsHardwareAccelerated() ? "hardware" : "software") << " CRC32C).\n";
+        }
 
-    while (buffer.ReadRecord(file)) {
-        string state = buffer.getState();
-        string zip = buffer.getZipCode();
-        double latitude = buffer.getLatitude();
-        double longitude = buffer.getLongitude();
+        IndexManager indexCheck;
+        ok = indexCheck.readIndex(indexFile) && ok;
 
-        if (all_states.find(state) == all_states.end()) {
-            all_states[state] = StateRecord{};
+        cout << (ok ? "Integrity check passed.\n" : "Integrity check FAILED.\n");
+        return ok ? 0 : 1;
+    }
+
+    // --- Apply a changeset in place before anything is read or cached ---
+    if (!applyFile.empty() && !applyChangesetFile(applyFile, binaryFile, nullptr)) return 1;
+
+    // Optionally check the checksum of the block(s) each looked-up record sits in
+    BlockChecksums lookupChecksums;
+    ifstream verifyStream;
+    if (verifyLookups) {
+        if (lookupChecksums.load(binaryFile)) {
+            verifyStream.open(binaryFile, ios::binary);
+        } else {
+            cerr << "Warning: no checksums for " << binaryFile << "; lookups will not be verified.\n";
+            verifyLookups = false;
         }
+    }
 
-        StateRecord& record = all_states[state];
-        if (longitude > record.easternmost_lon) { record.easternmost_lon = longitude; record.easternmost_zip = zip; }
-        if (longitude < record.westernmost_lon) { record.westernmost_lon = longitude; record.westernmost_zip = zip; }
-        if (latitude > record.northernmost_lat) { record.northernmost_lat = latitude; record.northernmost_zip = zip; }
-        if (latitude < record.southernmost_lat) { record.southernmost_lat = latitude; record.southernmost_zip = zip; }
+    // --- Part 1: State extremes report (cached, and only built when asked for) ---
+    // Shown with --report, or by default when no -Z lookups are given
+    bool reportRequested = true;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--report") { reportRequested = true; break; }
+        if (arg.rfind("-Z", 0) == 0 && arg.size() > 2) reportRequested = false;
     }
-    file.close();
-// Extreme headers for zipcode project 1
-    // Print state extremes summary
-    cout << left << setw(8) << "State"
-         << setw(15) << "Easternmost"
-         << setw(15) << "Westernmost"
-         << setw(15) << "Northernmost"
-         << setw(15) << "Southernmost"
-         << "\n";
-    cout << string(68, '-') << "\n";
 
-    for (const auto& pair : all_states) {
-        const auto& record = pair.second;
-        cout << left << setw(8) << pair.first
-             << setw(15) << record.easternmost_zip
-             << setw(15) << record.westernmost_zip
-             << setw(15) << record.northernmost_zip
-             << setw(15) << record.southernmost_zip
-             << "\n";
+    const string reportSource = "Data/converted_postal_codes.csv";
+    ResultCache reportCache(reportSource, "Data/report.cache");
+    reportCache.registerAggregate("state_extremes", [&](string& payload) {
+        map<string, StateRecord> all_states;
+        if (!computeStateExtremes(reportSource, all_states)) return false;
+        payload = serializeStateExtremes(all_states);
+        return true;
+    });
+
+    if (reportRequested) {
+        string payload;
+        map<string, StateRecord> all_states;
+        bool built = reportCache.get("state_extremes", payload) && deserializeStateExtremes(payload, all_states);
+        if (!built) {
+            // A damaged cache entry must not break the run: drop it and recompute from the source
+            reportCache.discard("state_extremes");
+            built = reportCache.get("state_extremes", payload) && deserializeStateExtremes(payload, all_states);
+        }
+        if (!built) {
+            cerr << "Error building state extremes report from " << reportSource << endl;
+            return 1;
+        }
+        printStateExtremes(all_states);
     }
 
     // --- Part 2: Load index and handle ZIP code flags ---
-    IndexManager index;
-    index.readIndex("Data/zip.idx");
+    // Lookups read an immutable snapshot; apply and reload publish a fresh one
+    ConcurrentIndex index;
+    publishIndex(index, indexFile, binaryFile);
 
     cout << "\n--- ZIP Code Search Results ---\n";
 
-    bool foundAny = false;
+    // Collect every -Z flag first so all the record reads can be issued as one batch
+    vector<string> zipInputs;
     for (int i = 1; i < argc; ++i) {
         string arg = argv[i];
 
         // Look for flags that start with "-Z"
         if (arg.rfind("-Z", 0) == 0 && arg.size() > 2) {
-            string zipInput = arg.substr(2); // Get the ZIP after "-Z"
-            foundAny = true;
+            zipInputs.push_back(arg.substr(2)); // Get the ZIP after "-Z"
+        }
+    }
+    bool foundAny = !zipInputs.empty();
 
-            uint64_t offset = index.findOffset(zipInput);
-            if (offset == UINT64_MAX) {
-                cout << "ZIP code " << zipInput << " not found.\n";
+    // Hot ZIP codes are served from memory, already formatted for output
+    HotRecordCache hotCache(cacheSize);
+    vector<string> rendered(zipInputs.size());
+    vector<bool> cached(zipInputs.size(), false);
+
+    vector<uint64_t> offsets;
+    vector<size_t> offsetOwner;        // offsets[k] was looked up for zipInputs[offsetOwner[k]]
+    {
+        ConcurrentIndex::ReadGuard snapshot = index.acquire(); // one snapshot for the whole batch
+        for (size_t i = 0; i < zipInputs.size(); ++i) {
+            if (hotCache.lookup(zipInputs[i], rendered[i])) {
+                cached[i] = true;
                 continue;
             }
-
-            ifstream binFile("Data/newBinaryPCodes.dat", ios::binary);
-            if (!binFile.is_open()) {
-                cerr << "Error opening binary data file.\n";
-                return 1;
+            uint64_t offset = snapshot ? snapshot->findOffset(zipInputs[i]) : UINT64_MAX;
+            if (offset != UINT64_MAX) {
+                offsets.push_back(offset);
+                offsetOwner.push_back(i);
             }
+        }
+    }
 
-            binFile.seekg(offset, ios::beg);
+    // One fetcher serves the -Z batch and the interactive lookups; opened on first use
+    unique_ptr<AsyncRecordFetcher> fetcher;
+    auto openFetcher = [&]() {
+        if (!fetcher) fetcher.reset(new AsyncRecordFetcher(binaryFile, static_cast<unsigned>(queueDepth)));
+        if (fetcher->isOpen()) return true;
+        cerr << "Error opening binary data file.\n";
+        fetcher.reset();
+        return false;
+    };
 
-            uint32_t recordLength;
-            binFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength));
+    vector<string> records(zipInputs.size());
+    vector<bool> fetched(zipInputs.size(), false);
+    vector<bool> corrupt(zipInputs.size(), false);
+    if (!offsets.empty()) {
+        if (!openFetcher()) return 1;
+        fetcher->fetchBatch(offsets, [&](size_t k, const string& record) {
+            if (verifyLookups && !lookupChecksums.verifyRange(verifyStream, offsets[k], sizeof(uint32_t) + record.size())) {
+                corrupt[offsetOwner[k]] = true;
+                return;
+            }
+            records[offsetOwner[k]] = record;
+            fetched[offsetOwner[k]] = true;
+        });
+    }
 
-            string record(recordLength, '\0');
-            binFile.read(&record[0], recordLength);
+    // Print in command-line order, whatever order the reads completed in
+    for (size_t i = 0; i < zipInputs.size(); ++i) {
+        const string& zipInput = zipInputs[i];
+        if (corrupt[i]) {
+            cerr << "Record for ZIP code " << zipInput << " failed its block checksum.\n";
+            continue;
+        }
+        if (!cached[i] && !fetched[i]) {
+            cout << "ZIP code " << zipInput << " not found.\n";
+            continue;
+        }
 
+        if (!cached[i]) {
             ZipCodeRecordBuffer zipBuffer;
-            istringstream ss(record);
-            if (zipBuffer.ReadRecord(ss)) {
-                cout << "---------------------------------------------\n";
-                cout << "ZIP Code: " << zipBuffer.getZipCode() << "\n"
-                     << "Place Name: " << zipBuffer.getPlaceName() << "\n"
-                     << "State: " << zipBuffer.getState() << "\n"
-                     << "County: " << zipBuffer.getCounty() << "\n"
-                     << "Latitude: " << zipBuffer.getLatitude() << "\n"
-                     << "Longitude: " << zipBuffer.getLongitude() << "\n";
-            } else {
+            istringstream ss(records[i]);
+            if (!zipBuffer.ReadRecord(ss)) {
                 cerr << "Error parsing record for ZIP code " << zipInput << endl;
+                continue;
             }
-
-            binFile.close();
+            hotCache.insert(zipInput, zipBuffer);
+            rendered[i] = HotRecordCache::render(zipBuffer);
         }
+
+        cout << "---------------------------------------------\n";
+        cout << rendered[i];
     }
 
     if (!foundAny) {
@@ -146,55 +461,95 @@ int main(int argc, char* argv[]) {
     // Interactive ZIP code lookup
     cout << "\n=== Interactive ZIP Code Lookup ===\n";
     cout << "Enter ZIP codes to search (numbers only) or enter 'q' to quit \n";
+    cout << "Enter 'apply <changeset>' to apply a changeset without restarting\n";
+    cout << "Enter 'reload' to pick up a data file and index changed by another process\n";
     
+    // After the data file changes: reopen it, swap in a fresh index snapshot (a lookup
+    // in flight keeps the old one) and reload the checksums lookups are verified against
+    auto reloadDataFile = [&]() {
+        fetcher.reset(); // compaction may have replaced the file under its descriptor
+        if (!publishIndex(index, indexFile, binaryFile)) {
+            cerr << "Error: could not reload the index; lookups use the previous one.\n";
+        }
+        if (verifyLookups) {
+            verifyStream.close();
+            if (lookupChecksums.load(binaryFile)) {
+                verifyStream.open(binaryFile, ios::binary);
+            } else {
+                cerr << "Warning: no checksums for " << binaryFile << "; lookups will not be verified.\n";
+                verifyLookups = false;
+            }
+        }
+    };
+
     string zipInput;
     while (true) {
         cout << "\nEnter ZIP code: ";
-        cin >> zipInput;
+        if (!(cin >> zipInput)) break; // end of input ends the session like 'q'
         
         if (zipInput == "q" || zipInput == "Q") break;
-        
-        cout << "\nSearching for ZIP code " << zipInput << "... (please wait)\n";
-        uint64_t offset = index.findOffset(zipInput);
-        if (offset == UINT64_MAX) {
-            cout << "ZIP code " << zipInput << " not found.\n";
+
+        // Only the ZIP codes the changeset actually modified drop out of the cache
+        if (zipInput == "apply") {
+            string changeset;
+            cin >> changeset;
+            applyChangesetFile(changeset, binaryFile, [&](const string& zip) { hotCache.invalidate(zip); });
+            reloadDataFile();
             cout << "\n========================================\n";
             continue;
         }
 
-        ifstream binFile("Data/newBinaryPCodes.dat", ios::binary);
-        if (!binFile.is_open()) {
-            cerr << "Error opening binary data file.\n";
-            break;
+        // Another process may have rewritten the file: every cached record is suspect
+        if (zipInput == "reload") {
+            reloadDataFile();
+            hotCache.clear();
+            cout << "Index reloaded (" << index.size() << " entries).\n";
+            cout << "\n========================================\n";
+            continue;
         }
+        
+        cout << "\nSearching for ZIP code " << zipInput << "... (please wait)\n";
+        string details;
+        if (!hotCache.lookup(zipInput, details)) {
+            uint64_t offset = index.findOffset(zipInput);
+            if (offset == UINT64_MAX) {
+                cout << "ZIP code " << zipInput << " not found.\n";
+                cout << "\n========================================\n";
+                continue;
+            }
 
-        binFile.seekg(offset, ios::beg);
-
-        uint32_t recordLength;
-        binFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength));
+            // Same read path as the -Z batch: the fetcher bounds the on-disk length by the file size
+            if (!openFetcher()) break;
+            string record;
+            if (!fetcher->fetchBatch({offset}, [&](size_t, const string& fetchedRecord) { record = fetchedRecord; })) {
+                cerr << "Error reading record for ZIP code " << zipInput << " at offset " << offset << ".\n";
+                continue;
+            }
 
-        string record(recordLength, '\0');
-        binFile.read(&record[0], recordLength);
+            if (verifyLookups && !lookupChecksums.verifyRange(verifyStream, offset, sizeof(uint32_t) + record.size())) {
+                cerr << "Record for ZIP code " << zipInput << " failed its block checksum.\n";
+                continue;
+            }
 
-        ZipCodeRecordBuffer zipBuffer;
-        istringstream ss(record);
-        if (zipBuffer.ReadRecord(ss)) {
-            cout << "\nFound ZIP code! Details:\n";
-            cout << "---------------------------------------------\n";
-            cout << "ZIP Code: " << zipBuffer.getZipCode() << "\n"
-                 << "Place Name: " << zipBuffer.getPlaceName() << "\n"
-                 << "State: " << zipBuffer.getState() << "\n"
-                 << "County: " << zipBuffer.getCounty() << "\n"
-                 << "Latitude: " << zipBuffer.getLatitude() << "\n"
-                 << "Longitude: " << zipBuffer.getLongitude() << "\n"
-                 << "---------------------------------------------\n";
-        } else {
-            cerr << "Error parsing record for ZIP code " << zipInput << endl;
+            ZipCodeRecordBuffer zipBuffer;
+            istringstream ss(record);
+            if (!zipBuffer.ReadRecord(ss)) {
+                cerr << "Error parsing record for ZIP code " << zipInput << endl;
+                continue;
+            }
+            hotCache.insert(zipInput, zipBuffer);
+            details = HotRecordCache::render(zipBuffer);
         }
 
-        binFile.close();
+        cout << "\nFound ZIP code! Details:\n";
+        cout << "---------------------------------------------\n";
+        cout << details
+             << "---------------------------------------------\n";
     }
 
+    HotRecordCache::Stats cacheStats = hotCache.stats();
+    cout << "\nRecord cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+         << cacheStats.evictions << " evictions.\n";
     cout << "\nProgram complete.\n";
     return 0;
 }
\ No newline at end of file
@@ -47,13 +47,21 @@ void readBinaryFile(const string& inputFileName, const string& outputFileName) {
     // Write CSV header row
     outputFile << "RecordLength,ZipCode,PlaceName,State,County,Latitude,Longitude\n";
 
-    // Read all records according to header record count
-    for (uint32_t i = 0; i < header.recordCount; ++i) {
-        uint32_t recordLength;
-        if (!inputFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength))) {
-            cerr << "Error reading record length!" << endl;
+    // Read every record slot to end of file; header record count only covers live
+    // records, so deleted (tombstoned) slots are skipped along the way
+    uint32_t liveRecords = 0;
+    uint32_t recordLength;
+    uint64_t offset = inputFile.tellg();
+    inputFile.seekg(0, ios::end);
+    uint64_t fileSize = inputFile.tellg();
+    inputFile.seekg(offset, ios::beg);
+    for (uint32_t i = 0; inputFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength)); ++i) {
+        // Don't trust a length that runs past the end of the file (torn write / truncation)
+        if (recordLength > fileSize - offset - sizeof(recordLength)) {
+            cerr << "Corrupt record length " << recordLength << " at offset " << offset << "!" << endl;
             break;
         }
+        offset += sizeof(recordLength) + recordLength;
 
         string record(recordLength, '\0');
         if (!inputFile.read(&record[0], recordLength)) {
@@ -61,6 +69,9 @@ void readBinaryFile(const string& inputFileName, const string& outputFileName) {
             break;
         }
 
+        if (!record.empty() && record[0] == '*') continue; // tombstone
+        ++liveRecords;
+
         ZipCodeRecordBuffer buffer;
         istringstream ss(record);
         if (buffer.ReadRecord(ss)) {
@@ -83,6 +94,11 @@ void readBinaryFile(const string& inputFileName, const string& outputFileName) {
          }
     }
 
+    if (liveRecords != header.recordCount) {
+        cerr << "Warning: header lists " << header.recordCount << " records but "
+             << liveRecords << " were found!" << endl;
+    }
+
     inputFile.close();
     outputFile.close();
 
@@ -0,0 +1,137 @@
+/**
+ * @file ConcurrentIndexTest.cpp
+ * @brief Runs reader threads against a publisher and checks that every reader
+ *        sees whole snapshots, a pinned snapshot outlives later publishes, and
+ *        retired snapshots are freed.
+ *
+ * Build and run from CSCI331GH:
+ *   g++ -std=c++17 -pthread -IHeaders Tests/ConcurrentIndexTest.cpp \
+ *       $(find SourceFiles -name '*.cpp' ! -name main.cpp) -o concurrent_index_test && ./concurrent_index_test
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentIndex.h"
+
+// Counts live heap blocks so the test can tell retired snapshots were freed
+static std::atomic<long> liveAllocations{0};
+
+void* operator new(std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    ++liveAllocations;
+    return p;
+}
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    --liveAllocations;
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+static const int KEYS = 64;
+static const int PUBLISHES = 200;
+static const int READERS = 8;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+/**
+ * @brief Snapshot @p version maps every key to the same offset, so a reader that
+ *        sees two different offsets in one guard saw a torn or freed snapshot.
+ */
+static std::unique_ptr<IndexManager> makeSnapshot(uint64_t version) {
+    std::unique_ptr<IndexManager> snapshot(new IndexManager());
+    for (int k = 0; k < KEYS; ++k) snapshot->setOffset(std::to_string(k), version);
+    return snapshot;
+}
+
+int main() {
+    long before = liveAllocations;
+    std::unique_ptr<IndexManager> probe = makeSnapshot(0);
+    const long blocksPerSnapshot = liveAllocations - before;
+    probe.reset();
+
+    ConcurrentIndex index;
+    check(index.findOffset("0") == UINT64_MAX, "nothing published yet");
+    index.publish(makeSnapshot(0));
+    long baseline = liveAllocations;
+
+    // One reader pins version 0 for the whole run
+    std::atomic<bool> pinned{false}, unpin{false};
+    std::atomic<bool> pinnedIntact{true};
+    std::thread pinnedReader([&] {
+        ConcurrentIndex::ReadGuard guard = index.acquire();
+        pinned = true;
+        while (!unpin) std::this_thread::yield();
+        for (int k = 0; k < KEYS; ++k) {
+            if (guard->findOffset(std::to_string(k)) != 0) pinnedIntact = false;
+        }
+    });
+    while (!pinned) std::this_thread::yield();
+
+    std::atomic<bool> stop{false};
+    std::atomic<long> torn{0}, backwards{0}, reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r) {
+        readers.emplace_back([&] {
+            uint64_t lastVersion = 0;
+            while (!stop) {
+                ConcurrentIndex::ReadGuard guard = index.acquire();
+                uint64_t version = guard->findOffset("0");
+                for (int k = 1; k < KEYS; ++k) {
+                    if (guard->findOffset(std::to_string(k)) != version) ++torn;
+                }
+                if (version < lastVersion) ++backwards;
+                lastVersion = version;
+                ++reads;
+            }
+        });
+    }
+
+    for (int v = 1; v <= PUBLISHES; ++v) {
+        index.publish(makeSnapshot(v));
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (std::thread& reader : readers) reader.join();
+
+    unpin = true;
+    pinnedReader.join();
+
+    check(reads > 0, "readers ran");
+    check(torn == 0, "every read saw one whole snapshot");
+    check(backwards == 0, "no reader saw an older snapshot after a newer one");
+    check(pinnedIntact, "a pinned snapshot survives later publishes");
+    check(index.findOffset("5") == PUBLISHES, "the last publish is current");
+
+    // Once no reader holds them, the next publish frees every retired snapshot
+    // (the reader records stay allocated until the index is destroyed)
+    index.publish(makeSnapshot(PUBLISHES + 1));
+    check(liveAllocations - baseline < blocksPerSnapshot, "retired snapshots were freed");
+
+    // A failed reload keeps the current snapshot
+    check(!index.reloadFromIndexFile("no_such_dir/zip.idx"), "reload from a missing file fails");
+    check(index.findOffset("5") == PUBLISHES + 1, "a failed reload keeps the current snapshot");
+
+    if (failures) {
+        std::cerr << failures << " check(s) failed.\n";
+        return 1;
+    }
+    std::cout << "All ConcurrentIndex checks passed (" << reads << " reads during " << PUBLISHES
+              << " publishes).\n";
+    return 0;
+}
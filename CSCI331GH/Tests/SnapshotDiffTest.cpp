@@ -0,0 +1,144 @@
+/**
+ * @file SnapshotDiffTest.cpp
+ * @brief Checks diffSnapshots' merge join and applyChangeset on ZIP codes with
+ *        leading zeros.
+ *
+ * Build and run from CSCI331GH:
+ *   g++ -std=c++17 -pthread -IHeaders Tests/SnapshotDiffTest.cpp \
+ *       $(find SourceFiles -name '*.cpp' ! -name main.cpp) -o snapshot_diff_test && ./snapshot_diff_test
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DataFileWriter.h"
+#include "SnapshotDiff.h"
+#include "ZipCodeDataFile.h"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+static bool writeDataFile(const std::string& dataFile, const std::string& indexFile,
+                          const std::vector<std::string>& records) {
+    DataFileWriter writer;
+    if (!writer.open(dataFile, indexFile)) return false;
+    for (const std::string& record : records) {
+        if (!writer.append(record)) return false;
+    }
+    return writer.close();
+}
+
+static const ChangeRecord* findChange(const std::vector<ChangeRecord>& changes, const std::string& zip) {
+    for (const ChangeRecord& change : changes) {
+        if (change.zip == zip) return &change;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Both data files name the same index in their headers (as every file
+ *        built by the program does); the older copy keeps its own index beside it.
+ */
+static void testMergeJoin(const std::string& dir) {
+    const std::string sharedIndex = dir + "/zip.idx";
+    check(writeDataFile(dir + "/old.dat", sharedIndex,
+                        {"501,Holtsville,NY,Suffolk,40.8154,-73.0451",
+                         "1001,Agawam,MA,Hampden,42.0702,-72.6227",
+                         "1002,Amherst,MA,Hampshire,42.3671,-72.4646"}),
+          "write old.dat");
+    std::rename(sharedIndex.c_str(), (dir + "/old.idx").c_str());
+    check(writeDataFile(dir + "/new.dat", sharedIndex,
+                        {"501,Holtsville,NY,Suffolk,40.8154,-73.0451",
+                         "1001,Agawam,MA,Hampden,42.1,-72.6227",
+                         "1003,Amherst,MA,Hampshire,42.3671,-72.4646"}),
+          "write new.dat");
+
+    std::vector<ChangeRecord> changes;
+    bool mergeJoined = false;
+    check(diffSnapshots(dir + "/old.dat", dir + "/new.dat", changes, &mergeJoined), "diff data files");
+    check(mergeJoined, "data files with their own indexes are merge-joined");
+    check(changes.size() == 3, "merge join finds three changes");
+    const ChangeRecord* changed = findChange(changes, "1001");
+    const ChangeRecord* removed = findChange(changes, "1002");
+    const ChangeRecord* added = findChange(changes, "1003");
+    check(changed && changed->op == ChangeRecord::CHANGED, "1001 changed");
+    check(removed && removed->op == ChangeRecord::REMOVED, "1002 removed");
+    check(added && added->op == ChangeRecord::ADDED, "1003 added");
+
+    // Without old.idx the shared index belongs to new.dat only: same result, hash join
+    std::filesystem::remove(dir + "/old.idx");
+    std::vector<ChangeRecord> hashed;
+    check(diffSnapshots(dir + "/old.dat", dir + "/new.dat", hashed, &mergeJoined), "diff without old.idx");
+    check(!mergeJoined, "a file without its own index falls back to the hash join");
+    check(hashed.size() == changes.size(), "hash join finds the same changes");
+}
+
+/**
+ * @brief A data file built from a padded export keys its index "00501"; changesets
+ *        carry "501". Applying must update that record, not add a second one.
+ */
+static void testLeadingZeros(const std::string& dir) {
+    const std::string dataFile = dir + "/padded.dat";
+    check(writeDataFile(dataFile, dir + "/padded.idx",
+                        {"00501,Holtsville,NY,Suffolk,40.8154,-73.0451",
+                         "01001,Agawam,MA,Hampden,42.0702,-72.6227"}),
+          "write padded.dat");
+
+    std::vector<ChangeRecord> changes(3);
+    changes[0].op = ChangeRecord::CHANGED;
+    changes[0].zip = "501";
+    changes[0].record = "501,Holtsville,NY,Suffolk,41,-73";
+    changes[1].op = ChangeRecord::REMOVED;
+    changes[1].zip = "1001";
+    changes[2].op = ChangeRecord::ADDED;
+    changes[2].zip = "1002";
+    changes[2].record = "1002,Amherst,MA,Hampshire,42.3671,-72.4646";
+
+    ZipCodeDataFile data;
+    check(data.open(dataFile), "open padded.dat");
+    std::vector<std::string> notified;
+    check(applyChangeset(changes, data, [&](const std::string& zip) { notified.push_back(zip); }),
+          "apply changeset to padded keys");
+
+    std::string key, record;
+    check(data.findKey("501", key) && key == "00501", "00501 keeps its stored spelling");
+    check(data.read("501", record) && record == "00501,Holtsville,NY,Suffolk,41,-73", "00501 was updated in place");
+    check(!data.findKey("1001", key), "01001 was removed");
+    check(data.read("1002", record), "1002 was added");
+    check(data.recordCount() == 2, "no duplicate record was inserted");
+    check(notified == std::vector<std::string>({"00501", "01001", "1002"}), "changes reported by stored key");
+    check(!data.insert("501,Holtsville,NY,Suffolk,41,-73"), "insert rejects another spelling of an existing ZIP");
+
+    // Re-applying is a no-op: every record already matches
+    notified.clear();
+    check(applyChangeset(changes, data, [&](const std::string& zip) { notified.push_back(zip); }),
+          "re-apply changeset");
+    check(notified.empty(), "re-applying changes nothing");
+    check(data.close(), "close padded.dat");
+}
+
+int main() {
+    const std::string dir = (std::filesystem::temp_directory_path() / "snapshot_diff_test").string();
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    testMergeJoin(dir);
+    testLeadingZeros(dir);
+
+    std::filesystem::remove_all(dir);
+    if (failures) {
+        std::cerr << failures << " check(s) failed.\n";
+        return 1;
+    }
+    std::cout << "All SnapshotDiff checks passed.\n";
+    return 0;
+}